@@ -0,0 +1,906 @@
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <memory_resource>
+#include <cstdint>
+#include <numeric>
+#include <ranges>
+#include <string>
+#include <vector>
+#include <xbit_vector/ascii.hpp>
+#include <xbit_vector/distance.hpp>
+#include <xbit_vector/fastx.hpp>
+#include <xbit_vector/io.hpp>
+#include <xbit_vector/kmers.hpp>
+#include <xbit_vector/parallel.hpp>
+#include <xbit_vector/rank_index.hpp>
+#include <xbit_vector/string_set.hpp>
+#include <xbit_vector/symbols.hpp>
+#include <xbit_vector/xbit_vector.hpp>
+
+#include "benchmark.hpp"
+
+using namespace biomodern;
+
+// Largest value + 1 stored by each container, std::vector<std::uint8_t> is used as a byte per
+// dibit baseline.
+template <typename C>
+constexpr unsigned alphabet = 4;
+
+template <std::unsigned_integral Block>
+constexpr unsigned alphabet<QuadbitVector<Block>> = 16;
+
+template <std::unsigned_integral Block>
+constexpr unsigned alphabet<XbitVector<5, Block>> = 20;
+
+template <>
+constexpr unsigned alphabet<std::vector<bool>> = 2;
+
+template <typename C>
+C make_random(std::size_t n, unsigned seed = 42) {
+  C c(n);
+  for (auto&& x : c) {
+    seed = seed * 1103515245u + 12345u;
+    x = static_cast<std::uint8_t>((seed >> 16) % alphabet<C>);
+  }
+  return c;
+}
+
+template <typename C>
+void bm_push_back(bench::State& state) {
+  const auto n = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    C c;
+    for (std::size_t i = 0; i < n; ++i) c.push_back(static_cast<std::uint8_t>(i % alphabet<C>));
+    bench::do_not_optimize(c);
+  }
+  state.set_items_processed(state.iterations() * n);
+}
+
+template <typename C>
+void bm_subscript(bench::State& state) {
+  const auto c = make_random<C>(state.range(0));
+  for (auto _ : state) {
+    unsigned sum = 0;
+    for (std::size_t i = 0; i < c.size(); ++i) sum += c[i];
+    bench::do_not_optimize(sum);
+  }
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+template <typename C>
+void bm_iterate(bench::State& state) {
+  const auto c = make_random<C>(state.range(0));
+  for (auto _ : state) {
+    unsigned sum = 0;
+    for (auto x : c) sum += x;
+    bench::do_not_optimize(sum);
+  }
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+template <typename C>
+void bm_insert_erase(bench::State& state) {
+  auto c = make_random<C>(state.range(0));
+  const auto pos = c.size() / 3;
+  for (auto _ : state) {
+    c.insert(c.begin() + pos, 1);
+    c.erase(c.begin() + pos + 7);
+    bench::do_not_optimize(c);
+  }
+  state.set_items_processed(state.iterations() * 2);
+}
+
+template <typename C>
+void bm_fill(bench::State& state) {
+  C c(state.range(0));
+  for (auto _ : state) {
+    c.assign(c.size(), 1);
+    bench::do_not_optimize(c);
+  }
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+template <typename C>
+void bm_flip(bench::State& state) {
+  auto c = make_random<C>(state.range(0));
+  for (auto _ : state) {
+    if constexpr (requires { c.flip(); }) c.flip();
+    else
+      std::ranges::transform(c, c.begin(), [](std::uint8_t x) { return x ^ 0b11u; });
+    bench::do_not_optimize(c);
+  }
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+template <typename C>
+void bm_compare(bench::State& state) {
+  const auto a = make_random<C>(state.range(0));
+  auto b = a;
+  b.back() = !b.back();
+  for (auto _ : state) {
+    bool r = a < b;
+    bench::do_not_optimize(r);
+  }
+  state.set_items_processed(state.iterations() * a.size());
+}
+
+template <typename C>
+void bm_count(bench::State& state) {
+  const auto c = make_random<C>(state.range(0));
+  for (auto _ : state) {
+    std::size_t r;
+    if constexpr (requires { c.count(1); }) r = c.count(1);
+    else
+      r = std::count(c.begin(), c.end(), 1);
+    bench::do_not_optimize(r);
+  }
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+template <typename C>
+void bm_histogram(bench::State& state) {
+  const auto c = make_random<C>(state.range(0));
+  for (auto _ : state) {
+    if constexpr (requires { c.histogram(); }) {
+      auto h = c.histogram();
+      bench::do_not_optimize(h);
+    } else {
+      std::array<std::size_t, alphabet<C>> h{};
+      for (auto x : c) ++h[x];
+      bench::do_not_optimize(h);
+    }
+  }
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+// Scan for the only non-zero element, which is the last one.
+template <typename C>
+void bm_find(bench::State& state) {
+  C c(state.range(0));
+  c.back() = 1;
+  for (auto _ : state) {
+    using std::find;
+    auto it = find(c.begin(), c.end(), 1);
+    bench::do_not_optimize(it);
+  }
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+template <typename C>
+void bm_ranges_sort(bench::State& state) {
+  const auto src = make_random<C>(state.range(0));
+  C c;
+  for (auto _ : state) {
+    state.pause_timing();
+    c = src;
+    state.resume_timing();
+    std::ranges::sort(c);
+    bench::do_not_optimize(c);
+  }
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+// std::vector<bool> is not sortable with std::ranges::sort, std::sort is used instead.
+template <>
+void bm_ranges_sort<std::vector<bool>>(bench::State& state) {
+  const auto src = make_random<std::vector<bool>>(state.range(0));
+  std::vector<bool> c;
+  for (auto _ : state) {
+    state.pause_timing();
+    c = src;
+    state.resume_timing();
+    std::sort(c.begin(), c.end());
+    bench::do_not_optimize(c);
+  }
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+// The counting sort found by ADL, for xbit containers only.
+template <typename C>
+void bm_sort(bench::State& state) {
+  const auto src = make_random<C>(state.range(0));
+  C c;
+  for (auto _ : state) {
+    state.pause_timing();
+    c = src;
+    state.resume_timing();
+    sort(c);
+    bench::do_not_optimize(c);
+  }
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+// Maps every symbol through a table, the complement here.
+template <typename C>
+void bm_transform_symbols(bench::State& state) {
+  constexpr std::size_t N = sizeof(typename C::block_type) * 8 / C::xbits_per_block;
+  auto lut = std::array<std::uint8_t, (1 << N)>{};
+  for (std::size_t x = 0; x < lut.size(); ++x) lut[x] = static_cast<std::uint8_t>(~x);
+  auto c = make_random<C>(state.range(0));
+  for (auto _ : state) {
+    transform_symbols(c, lut);
+    bench::do_not_optimize(c);
+  }
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+// Same through the proxy reference.
+template <typename C>
+void bm_ranges_transform_symbols(bench::State& state) {
+  constexpr std::size_t N = sizeof(typename C::block_type) * 8 / C::xbits_per_block;
+  auto lut = std::array<std::uint8_t, (1 << N)>{};
+  for (std::size_t x = 0; x < lut.size(); ++x) lut[x] = static_cast<std::uint8_t>(~x);
+  auto c = make_random<C>(state.range(0));
+  for (auto _ : state) {
+    std::ranges::transform(c, c.begin(), [&](std::uint8_t x) { return lut[x]; });
+    bench::do_not_optimize(c);
+  }
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+// Dibits to one-hot quadbits and back, range(0) bases.
+template <typename C>
+void bm_widen(bench::State& state) {
+  const auto c = make_random<C>(state.range(0));
+  for (auto _ : state) {
+    auto q = widen(c, DibitEncoding::one_hot);
+    bench::do_not_optimize(q);
+  }
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+template <typename C>
+void bm_narrow(bench::State& state) {
+  const auto q = widen(make_random<C>(state.range(0)), DibitEncoding::one_hot);
+  for (auto _ : state) {
+    auto c = narrow(q, DibitEncoding::one_hot);
+    bench::do_not_optimize(c);
+  }
+  state.set_items_processed(state.iterations() * q.size());
+}
+
+// Same an element at a time.
+template <typename C>
+void bm_widen_elementwise(bench::State& state) {
+  const auto c = make_random<C>(state.range(0));
+  for (auto _ : state) {
+    auto q = QuadbitVector<typename C::block_type>(c.size());
+    std::ranges::transform(c, q.begin(), [](std::uint8_t x) { return 1 << x; });
+    bench::do_not_optimize(q);
+  }
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+template <typename C>
+void bm_reverse_complement(bench::State& state) {
+  auto c = make_random<C>(state.range(0));
+  for (auto _ : state) {
+    c.reverse_complement();
+    bench::do_not_optimize(c);
+  }
+  state.set_bytes_processed(state.iterations() * c.num_blocks() * sizeof(*c.data()));
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+template <typename C>
+void bm_reverse_complement_copy(bench::State& state) {
+  const auto c = make_random<C>(state.range(0));
+  C out;
+  for (auto _ : state) {
+    c.reverse_complement(out);
+    bench::do_not_optimize(out);
+  }
+  state.set_bytes_processed(state.iterations() * c.num_blocks() * sizeof(*c.data()));
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+// The proxy iterator idiom shown in the README.
+template <typename C>
+void bm_reverse_complement_view(bench::State& state) {
+  const auto c = make_random<C>(state.range(0));
+  C out(c.size());
+  for (auto _ : state) {
+    std::ranges::copy(
+        c | std::views::reverse | std::views::transform([](auto x) { return 0b11u - x; }),
+        out.begin());
+    bench::do_not_optimize(out);
+  }
+  state.set_bytes_processed(state.iterations() * c.num_blocks() * sizeof(*c.data()));
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+std::string make_bases(std::size_t n) {
+  std::string s(n, 'A');
+  unsigned seed = 42;
+  for (auto& c : s) {
+    seed = seed * 1103515245u + 12345u;
+    c = "ACGT"[seed >> 16 & 3];
+  }
+  return s;
+}
+
+template <typename C>
+void bm_pack_ascii(bench::State& state) {
+  const auto s = make_bases(state.range(0));
+  C c;
+  for (auto _ : state) {
+    c.clear();
+    pack_ascii(s, c);
+    bench::do_not_optimize(c);
+  }
+  state.set_bytes_processed(state.iterations() * s.size());
+}
+
+template <typename C>
+void bm_unpack_ascii(bench::State& state) {
+  C c;
+  pack_ascii(make_bases(state.range(0)), c);
+  std::string s(c.size(), ' ');
+  for (auto _ : state) {
+    unpack_ascii(c, s.data());
+    bench::do_not_optimize(s);
+  }
+  state.set_bytes_processed(state.iterations() * s.size());
+}
+
+// Per character transform through the proxy reference.
+template <typename C>
+void bm_pack_ascii_transform(bench::State& state) {
+  const auto s = make_bases(state.range(0));
+  C c;
+  for (auto _ : state) {
+    c.assign(s.size(), 0);
+    std::ranges::transform(s, c.begin(), [](char x) { return (x >> 1 ^ x >> 2) & 3; });
+    bench::do_not_optimize(c);
+  }
+  state.set_bytes_processed(state.iterations() * s.size());
+}
+
+// The range(0) bases from every position as one integer.
+template <typename C>
+void bm_get_bits(bench::State& state) {
+  const auto c = make_random<C>(1 << 20);
+  const auto k = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i + k <= c.size(); ++i) sum += c.get_bits(i, k);
+    bench::do_not_optimize(sum);
+  }
+  state.set_items_processed(state.iterations() * (c.size() - k + 1));
+}
+
+// Same assembled from operator[].
+template <typename C>
+void bm_get_bits_subscript(bench::State& state) {
+  const auto c = make_random<C>(1 << 20);
+  const auto k = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i + k <= c.size(); ++i) {
+      std::uint64_t x = 0;
+      for (std::size_t j = k; j-- > 0;) x = x << 2 | c[i + j];
+      sum += x;
+    }
+    bench::do_not_optimize(sum);
+  }
+  state.set_items_processed(state.iterations() * (c.size() - k + 1));
+}
+
+// Sets range(0) bases at every position.
+template <typename C>
+void bm_set_bits(bench::State& state) {
+  auto c = make_random<C>(1 << 20);
+  const auto k = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    for (std::size_t i = 0; i + k <= c.size(); ++i) c.set_bits(i, k, i * 0x9e3779b97f4a7c15u);
+    bench::do_not_optimize(c);
+  }
+  state.set_items_processed(state.iterations() * (c.size() - k + 1));
+}
+
+// Cuts windows of range(0) bases at odd offsets out of a chromosome.
+template <typename C>
+void bm_substr(bench::State& state) {
+  const auto c = make_random<C>(1 << 24);
+  const auto len = static_cast<std::size_t>(state.range(0));
+  std::size_t n = 0;
+  for (auto _ : state) {
+    for (std::size_t pos = 0; pos + len <= c.size(); pos += 4093, ++n) {
+      const auto w = c.substr(pos, len);
+      bench::do_not_optimize(w.data());
+    }
+  }
+  state.set_items_processed(n * len);
+}
+
+// Concatenates range(0)-base windows at odd offsets into one scaffold.
+template <typename C>
+void bm_append(bench::State& state) {
+  const auto c = make_random<C>(1 << 24);
+  const auto len = static_cast<std::size_t>(state.range(0));
+  auto scaffold = C{};
+  scaffold.reserve(c.size());
+  for (auto _ : state) {
+    scaffold.clear();
+    for (std::size_t pos = 3; pos + len <= c.size(); pos += len + 7) scaffold.append(c, pos, len);
+    bench::do_not_optimize(scaffold.data());
+  }
+  state.set_items_processed(state.iterations() * scaffold.size());
+}
+
+// Same a base at a time through push_back.
+template <typename C>
+void bm_append_push_back(bench::State& state) {
+  const auto c = make_random<C>(1 << 24);
+  const auto len = static_cast<std::size_t>(state.range(0));
+  auto scaffold = C{};
+  scaffold.reserve(c.size());
+  for (auto _ : state) {
+    scaffold.clear();
+    for (std::size_t pos = 3; pos + len <= c.size(); pos += len + 7)
+      for (std::size_t i = pos; i < pos + len; ++i) scaffold.push_back(c[i]);
+    bench::do_not_optimize(scaffold.data());
+  }
+  state.set_items_processed(state.iterations() * scaffold.size());
+}
+
+// Re-read the k bases of every position through operator[].
+template <typename C>
+void bm_kmers_subscript(bench::State& state) {
+  const auto c = make_random<C>(1 << 20);
+  const auto k = static_cast<std::size_t>(state.range(0));
+  for (auto _ : state) {
+    std::uint64_t sum = 0;
+    for (std::size_t i = 0; i + k <= c.size(); ++i) {
+      std::uint64_t kmer = 0;
+      for (std::size_t j = 0; j < k; ++j) kmer = kmer << 2 | c[i + j];
+      sum += kmer;
+    }
+    bench::do_not_optimize(sum);
+  }
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+template <typename C>
+void bm_kmers(bench::State& state) {
+  const auto c = make_random<C>(1 << 20);
+  for (auto _ : state) {
+    std::uint64_t sum = 0;
+    for (auto kmer : kmers(c, state.range(0))) sum += kmer;
+    bench::do_not_optimize(sum);
+  }
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+template <typename C>
+void bm_canonical_kmers(bench::State& state) {
+  const auto c = make_random<C>(1 << 20);
+  for (auto _ : state) {
+    std::uint64_t sum = 0;
+    for (auto kmer : canonical_kmers(c, state.range(0))) sum += kmer;
+    bench::do_not_optimize(sum);
+  }
+  state.set_items_processed(state.iterations() * c.size());
+}
+
+// A read of range(0) bases with a mismatch every 16 bases, checked against every position of a
+// 1 Mbp reference as in seed verification.
+template <typename C>
+void bm_hamming(bench::State& state) {
+  const auto ref = make_random<C>(1 << 20);
+  const auto len = static_cast<std::size_t>(state.range(0));
+  C read(ref.begin() + 1000, ref.begin() + 1000 + len);
+  for (std::size_t i = 0; i < len; i += 16) read[i] = static_cast<std::uint8_t>(read[i] ^ 1);
+  for (auto _ : state) {
+    std::size_t sum = 0;
+    for (std::size_t pos = 0; pos + len <= ref.size(); ++pos)
+      sum += hamming(read, 0, ref, pos, len);
+    bench::do_not_optimize(sum);
+  }
+  state.set_items_processed(state.iterations() * (ref.size() - len + 1));
+}
+
+// Same with candidates rejected past 4 mismatches.
+template <typename C>
+void bm_hamming_at_most(bench::State& state) {
+  const auto ref = make_random<C>(1 << 20);
+  const auto len = static_cast<std::size_t>(state.range(0));
+  C read(ref.begin() + 1000, ref.begin() + 1000 + len);
+  for (std::size_t i = 0; i < len; i += 16) read[i] = static_cast<std::uint8_t>(read[i] ^ 1);
+  for (auto _ : state) {
+    std::size_t hits = 0;
+    for (std::size_t pos = 0; pos + len <= ref.size(); ++pos)
+      hits += hamming_at_most(read, 0, ref, pos, len, 4) <= 4;
+    bench::do_not_optimize(hits);
+  }
+  state.set_items_processed(state.iterations() * (ref.size() - len + 1));
+}
+
+// Same as bm_hamming through the proxy references.
+template <typename C>
+void bm_hamming_proxy(bench::State& state) {
+  const auto ref = make_random<C>(1 << 20);
+  const auto len = static_cast<std::size_t>(state.range(0));
+  C read(ref.begin() + 1000, ref.begin() + 1000 + len);
+  for (std::size_t i = 0; i < len; i += 16) read[i] = static_cast<std::uint8_t>(read[i] ^ 1);
+  for (auto _ : state) {
+    std::size_t sum = 0;
+    for (std::size_t pos = 0; pos + len <= ref.size(); ++pos)
+      for (std::size_t i = 0; i < len; ++i) sum += read[i] != ref[pos + i];
+    bench::do_not_optimize(sum);
+  }
+  state.set_items_processed(state.iterations() * (ref.size() - len + 1));
+}
+
+// Approximate search of a pattern of range(0) bases in 1 Mbp with up to 4 edits.
+template <typename C>
+void bm_approximate_search(bench::State& state) {
+  const auto text = make_random<C>(1 << 20);
+  const auto len = static_cast<std::size_t>(state.range(0));
+  const MyersPattern<2> pattern(C(text.begin() + 1000, text.begin() + 1000 + len));
+  for (auto _ : state) {
+    std::size_t hits = 0;
+    pattern.search(text, 4, [&](std::size_t, std::size_t) { ++hits; });
+    bench::do_not_optimize(hits);
+  }
+  state.set_items_processed(state.iterations() * text.size());
+}
+
+// Global distance between two related sequences of range(0) bases, within a band of range(1)
+// (0 for none).
+template <typename C>
+void bm_edit_distance(bench::State& state) {
+  const auto a = make_random<C>(state.range(0));
+  auto b = a;
+  for (std::size_t i = 0; i < b.size(); i += 50) b[i] = static_cast<std::uint8_t>(b[i] ^ 1);
+  for (std::size_t i = 25; i < b.size(); i += 500) b.erase(b.begin() + i);
+  const auto band = state.range(1) ? static_cast<std::size_t>(state.range(1)) : a.size();
+  const MyersPattern<2> pattern(a);
+  for (auto _ : state) bench::do_not_optimize(pattern.distance(b, band));
+  state.set_items_processed(state.iterations() * b.size());
+}
+
+// Random blocks, built once per container type and shared by the benchmarks since filling a
+// 1 Gbp vector element by element would dominate the run time.
+template <typename C>
+const C& random_blocks(std::size_t n) {
+  static C c;
+  if (c.size() != n) {
+    c.resize(n);
+    std::uint64_t seed = 42;
+    for (std::size_t i = 0; i < c.num_blocks(); ++i) {
+      seed = seed * 6364136223846793005u + 1442695040888963407u;
+      c.data()[i] = static_cast<typename C::block_type>(seed >> 11);
+    }
+  }
+  return c;
+}
+
+std::vector<std::size_t> random_positions(std::size_t n, std::size_t count = 1 << 16) {
+  std::vector<std::size_t> r(count);
+  std::uint64_t seed = 7;
+  for (auto& x : r) {
+    seed = seed * 6364136223846793005u + 1442695040888963407u;
+    x = (seed >> 11) % (n + 1);
+  }
+  return r;
+}
+
+template <typename C, typename Index>
+void bm_rank(bench::State& state) {
+  const auto& c = random_blocks<C>(state.range(0));
+  static const Index index(c);
+  const auto positions = random_positions(c.size());
+  std::size_t i = 0, r = 0;
+  for (auto _ : state) {
+    r += index.rank(static_cast<std::uint8_t>(i % Index::sigma), positions[i % positions.size()]);
+    ++i;
+  }
+  bench::do_not_optimize(r);
+  state.set_items_processed(state.iterations());
+  const auto payload = c.num_blocks() * sizeof(typename C::block_type);
+  state.set_label("index_overhead=" + std::to_string(100 * index.index_bytes() / payload) + "%");
+}
+
+template <typename C, typename Index>
+void bm_select(bench::State& state) {
+  const auto& c = random_blocks<C>(state.range(0));
+  static const Index index(c);
+  const auto positions = random_positions(index.count(1) - 1);
+  std::size_t i = 0, r = 0;
+  for (auto _ : state) r += index.select(1, positions[i++ % positions.size()]);
+  bench::do_not_optimize(r);
+  state.set_items_processed(state.iterations());
+}
+
+// Saved once per container type and size in the temporary directory.
+template <typename C>
+std::filesystem::path saved_random(std::size_t n) {
+  const auto p = std::filesystem::temp_directory_path() /
+                 ("xbit_vector_bench_" + std::to_string(sizeof(typename C::block_type)) + "_" +
+                  std::to_string(n) + ".xbv");
+  if (!std::filesystem::exists(p)) save(random_blocks<C>(n), p);
+  return p;
+}
+
+template <typename C>
+void bm_load(bench::State& state) {
+  const auto p = saved_random<C>(state.range(0));
+  C c;
+  for (auto _ : state) {
+    load(p, c);
+    bench::do_not_optimize(c);
+  }
+  state.set_bytes_processed(state.iterations() * c.num_blocks() * sizeof(typename C::block_type));
+}
+
+template <typename Mapping>
+void bm_map(bench::State& state) {
+  const auto p = saved_random<DibitVector<typename Mapping::span_type::block_type>>(state.range(0));
+  for (auto _ : state) {
+    auto m = map<Mapping>(p);
+    bench::do_not_optimize(m);
+  }
+  state.set_items_processed(state.iterations());
+}
+
+// A FASTQ file of 64 Mbp in reads of range(0) bases, read directly (range(1) == 0) or with the
+// input split on a second thread (range(1) == 1).
+template <typename C>
+void bm_fastx(bench::State& state) {
+  const auto len = static_cast<std::size_t>(state.range(0));
+  const auto p = std::filesystem::temp_directory_path() /
+                 ("xbit_vector_bench_" + std::to_string(len) + ".fq");
+  if (!std::filesystem::exists(p)) {
+    const auto bases = make_bases(std::size_t{1} << 26);
+    std::ofstream out(p, std::ios::binary);
+    for (std::size_t i = 0; i + len <= bases.size(); i += len)
+      out << "@read" << i / len << '\n'
+          << std::string_view(bases).substr(i, len) << "\n+\n"
+          << std::string(len, 'I') << '\n';
+  }
+  FastxRecord<typename C::block_type> r;
+  std::size_t n = 0;
+  for (auto _ : state) {
+    const int fd = ::open(p.c_str(), O_RDONLY);
+    FastxReader<typename C::block_type> reader(fd, {.pipelined = state.range(1) != 0});
+    while (reader.read(r)) n += r.seq.size();
+    ::close(fd);
+    bench::do_not_optimize(n);
+  }
+  state.set_bytes_processed(state.iterations() * std::filesystem::file_size(p));
+}
+
+// range(0) reads of 150 bases packed into vectors of their own, then all released.
+template <typename C>
+void bm_reads_malloc(bench::State& state) {
+  const auto s = make_bases(150);
+  for (auto _ : state) {
+    std::vector<C> reads;
+    reads.reserve(state.range(0));
+    for (std::int64_t i = 0; i < state.range(0); ++i) pack_ascii(s, reads.emplace_back());
+    bench::do_not_optimize(reads);
+  }
+  state.set_items_processed(state.iterations() * state.range(0));
+}
+
+// Same with the vectors and their blocks drawn from an arena released as a whole, whose buffer
+// is reused from one batch to the next.
+template <typename C>
+void bm_reads_arena(bench::State& state) {
+  const auto s = make_bases(150);
+  std::vector<std::byte> buffer(state.range(0) * 128);
+  std::pmr::monotonic_buffer_resource arena(buffer.data(), buffer.size());
+  for (auto _ : state) {
+    {
+      std::pmr::vector<C> reads(&arena);
+      reads.reserve(state.range(0));
+      for (std::int64_t i = 0; i < state.range(0); ++i) pack_ascii(s, reads.emplace_back());
+      bench::do_not_optimize(reads);
+    }
+    arena.release();
+  }
+  state.set_items_processed(state.iterations() * state.range(0));
+}
+
+// Same with the reads appended to one string set, which is cleared and refilled.
+template <typename S>
+void bm_reads_string_set(bench::State& state) {
+  const auto s = make_bases(150);
+  S reads;
+  reads.reserve(state.range(0), state.range(0) * s.size());
+  for (auto _ : state) {
+    reads.clear();
+    for (std::int64_t i = 0; i < state.range(0); ++i) pack_ascii(s, reads.emplace_back(s.size()));
+    bench::do_not_optimize(reads);
+  }
+  state.set_items_processed(state.iterations() * state.range(0));
+}
+
+// One vector of range(0) xbits shared by the scaling benchmarks, which run on range(1) threads.
+template <typename C>
+C& shared_vector(std::size_t n) {
+  static C c;
+  c.resize(n);
+  return c;
+}
+
+template <typename C>
+void bm_parallel_flip(bench::State& state) {
+  auto& c = shared_vector<C>(state.range(0));
+  ThreadPool pool(state.range(1));
+  for (auto _ : state) {
+    flip(pool, c);
+    bench::clobber_memory();
+  }
+  state.set_bytes_processed(state.iterations() * c.num_blocks() * sizeof(typename C::block_type));
+}
+
+template <typename C>
+void bm_parallel_count(bench::State& state) {
+  const auto& c = shared_vector<C>(state.range(0));
+  ThreadPool pool(state.range(1));
+  for (auto _ : state) {
+    auto n = count(pool, c, 1);
+    bench::do_not_optimize(n);
+  }
+  state.set_bytes_processed(state.iterations() * c.num_blocks() * sizeof(typename C::block_type));
+}
+
+template <typename C>
+void bm_parallel_reverse_complement(bench::State& state) {
+  auto& c = shared_vector<C>(state.range(0));
+  ThreadPool pool(state.range(1));
+  for (auto _ : state) {
+    reverse_complement(pool, c);
+    bench::clobber_memory();
+  }
+  state.set_bytes_processed(state.iterations() * c.num_blocks() * sizeof(typename C::block_type));
+}
+
+// Packs range(0) / 8 bases over the front of the shared vector.
+template <typename C>
+void bm_parallel_pack_ascii(bench::State& state) {
+  auto& c = shared_vector<C>(state.range(0));
+  const auto s = make_bases(c.size() / 8);
+  ThreadPool pool(state.range(1));
+  for (auto _ : state) {
+    auto n = pack_ascii(pool, s, DibitSpan<typename C::block_type>(c));
+    bench::do_not_optimize(n);
+  }
+  state.set_bytes_processed(state.iterations() * s.size());
+}
+
+using Dibit8 = DibitVector<std::uint8_t>;
+using Dibit16 = DibitVector<std::uint16_t>;
+using Dibit32 = DibitVector<std::uint32_t>;
+using Dibit64 = DibitVector<std::uint64_t>;
+using Quadbit8 = QuadbitVector<std::uint8_t>;
+using Quadbit16 = QuadbitVector<std::uint16_t>;
+using Quadbit32 = QuadbitVector<std::uint32_t>;
+using Quadbit64 = QuadbitVector<std::uint64_t>;
+using Fivebit8 = XbitVector<5, std::uint8_t>;
+using Fivebit64 = XbitVector<5, std::uint64_t>;
+using Bytes = std::vector<std::uint8_t>;
+using Bits = std::vector<bool>;
+
+#define XBIT_BENCHMARK_CONTAINERS(fn, n)   \
+  BENCHMARK_TEMPLATE(fn, Dibit8)->arg(n);    \
+  BENCHMARK_TEMPLATE(fn, Dibit16)->arg(n);   \
+  BENCHMARK_TEMPLATE(fn, Dibit32)->arg(n);   \
+  BENCHMARK_TEMPLATE(fn, Dibit64)->arg(n);   \
+  BENCHMARK_TEMPLATE(fn, Quadbit8)->arg(n);  \
+  BENCHMARK_TEMPLATE(fn, Quadbit16)->arg(n); \
+  BENCHMARK_TEMPLATE(fn, Quadbit32)->arg(n); \
+  BENCHMARK_TEMPLATE(fn, Quadbit64)->arg(n); \
+  BENCHMARK_TEMPLATE(fn, Bytes)->arg(n);     \
+  BENCHMARK_TEMPLATE(fn, Bits)->arg(n)
+
+XBIT_BENCHMARK_CONTAINERS(bm_push_back, 1 << 20);
+XBIT_BENCHMARK_CONTAINERS(bm_subscript, 1 << 20);
+XBIT_BENCHMARK_CONTAINERS(bm_iterate, 1 << 20);
+XBIT_BENCHMARK_CONTAINERS(bm_insert_erase, 1 << 20);
+XBIT_BENCHMARK_CONTAINERS(bm_fill, 1 << 20);
+XBIT_BENCHMARK_CONTAINERS(bm_flip, 1 << 20);
+XBIT_BENCHMARK_CONTAINERS(bm_compare, 1 << 20);
+XBIT_BENCHMARK_CONTAINERS(bm_count, 1 << 20);
+XBIT_BENCHMARK_CONTAINERS(bm_histogram, 1 << 20);
+XBIT_BENCHMARK_CONTAINERS(bm_find, 1 << 20);
+XBIT_BENCHMARK_CONTAINERS(bm_ranges_sort, 1 << 16);
+BENCHMARK_TEMPLATE(bm_sort, Dibit8)->arg(1 << 16);
+BENCHMARK_TEMPLATE(bm_sort, Dibit64)->arg(1 << 16);
+BENCHMARK_TEMPLATE(bm_sort, Quadbit8)->arg(1 << 16);
+BENCHMARK_TEMPLATE(bm_sort, Quadbit64)->arg(1 << 16);
+BENCHMARK_TEMPLATE(bm_transform_symbols, Dibit8)->arg(1 << 20);
+BENCHMARK_TEMPLATE(bm_transform_symbols, Dibit64)->arg(1 << 20);
+BENCHMARK_TEMPLATE(bm_transform_symbols, Quadbit8)->arg(1 << 20);
+BENCHMARK_TEMPLATE(bm_transform_symbols, Quadbit64)->arg(1 << 20);
+BENCHMARK_TEMPLATE(bm_ranges_transform_symbols, Dibit64)->arg(1 << 20);
+BENCHMARK_TEMPLATE(bm_ranges_transform_symbols, Quadbit64)->arg(1 << 20);
+BENCHMARK_TEMPLATE(bm_widen, Dibit8)->arg(1 << 20);
+BENCHMARK_TEMPLATE(bm_widen, Dibit64)->arg(1 << 20);
+BENCHMARK_TEMPLATE(bm_widen_elementwise, Dibit64)->arg(1 << 20);
+BENCHMARK_TEMPLATE(bm_narrow, Dibit8)->arg(1 << 20);
+BENCHMARK_TEMPLATE(bm_narrow, Dibit64)->arg(1 << 20);
+
+// Amino acids packed densely, their xbits straddle blocks.
+#define XBIT_BENCHMARK_FIVEBIT(fn, n)     \
+  BENCHMARK_TEMPLATE(fn, Fivebit8)->arg(n); \
+  BENCHMARK_TEMPLATE(fn, Fivebit64)->arg(n)
+
+XBIT_BENCHMARK_FIVEBIT(bm_push_back, 1 << 20);
+XBIT_BENCHMARK_FIVEBIT(bm_subscript, 1 << 20);
+XBIT_BENCHMARK_FIVEBIT(bm_iterate, 1 << 20);
+XBIT_BENCHMARK_FIVEBIT(bm_fill, 1 << 20);
+XBIT_BENCHMARK_FIVEBIT(bm_compare, 1 << 20);
+XBIT_BENCHMARK_FIVEBIT(bm_count, 1 << 20);
+
+BENCHMARK_TEMPLATE(bm_reverse_complement, Dibit8)->arg(1 << 26);
+BENCHMARK_TEMPLATE(bm_reverse_complement, Dibit16)->arg(1 << 26);
+BENCHMARK_TEMPLATE(bm_reverse_complement, Dibit32)->arg(1 << 26);
+BENCHMARK_TEMPLATE(bm_reverse_complement, Dibit64)->arg(1 << 26)->arg((1 << 26) - 3);
+BENCHMARK_TEMPLATE(bm_reverse_complement_copy, Dibit64)->arg(1 << 26)->arg((1 << 26) - 3);
+BENCHMARK_TEMPLATE(bm_reverse_complement_view, Dibit64)->arg(1 << 26);
+
+BENCHMARK_TEMPLATE(bm_pack_ascii, Dibit8)->arg(1 << 24);
+BENCHMARK_TEMPLATE(bm_pack_ascii, Dibit64)->arg(1 << 24);
+BENCHMARK_TEMPLATE(bm_pack_ascii_transform, Dibit64)->arg(1 << 24);
+BENCHMARK_TEMPLATE(bm_unpack_ascii, Dibit8)->arg(1 << 24);
+BENCHMARK_TEMPLATE(bm_unpack_ascii, Dibit64)->arg(1 << 24);
+
+BENCHMARK_TEMPLATE(bm_get_bits, Dibit8)->arg(20);
+BENCHMARK_TEMPLATE(bm_get_bits, Dibit16)->arg(20);
+BENCHMARK_TEMPLATE(bm_get_bits, Dibit32)->arg(20);
+BENCHMARK_TEMPLATE(bm_get_bits, Dibit64)->arg(20);
+BENCHMARK_TEMPLATE(bm_get_bits_subscript, Dibit64)->arg(20);
+BENCHMARK_TEMPLATE(bm_set_bits, Dibit8)->arg(20);
+BENCHMARK_TEMPLATE(bm_set_bits, Dibit64)->arg(20);
+BENCHMARK_TEMPLATE(bm_substr, Dibit8)->arg(150)->arg(10000);
+BENCHMARK_TEMPLATE(bm_substr, Dibit64)->arg(150)->arg(10000);
+BENCHMARK_TEMPLATE(bm_append, Dibit8)->arg(150);
+BENCHMARK_TEMPLATE(bm_append, Dibit64)->arg(150);
+BENCHMARK_TEMPLATE(bm_append_push_back, Dibit64)->arg(150);
+
+BENCHMARK_TEMPLATE(bm_kmers_subscript, Dibit64)->arg(31);
+BENCHMARK_TEMPLATE(bm_kmers, Dibit8)->arg(31);
+BENCHMARK_TEMPLATE(bm_kmers, Dibit64)->arg(31);
+BENCHMARK_TEMPLATE(bm_canonical_kmers, Dibit64)->arg(31);
+
+BENCHMARK_TEMPLATE(bm_hamming, Dibit8)->arg(150);
+BENCHMARK_TEMPLATE(bm_hamming, Dibit64)->arg(150);
+BENCHMARK_TEMPLATE(bm_hamming, Quadbit64)->arg(150);
+BENCHMARK_TEMPLATE(bm_hamming_at_most, Dibit64)->arg(150);
+BENCHMARK_TEMPLATE(bm_hamming_proxy, Dibit64)->arg(150);
+BENCHMARK_TEMPLATE(bm_approximate_search, Dibit64)->arg(64)->arg(150)->arg(1000);
+BENCHMARK_TEMPLATE(bm_edit_distance, Dibit64)->args({10000, 0})->args({10000, 64});
+
+BENCHMARK_TEMPLATE(bm_rank, Dibit64, DibitRankIndex<std::uint64_t>)->arg(1 << 30);
+BENCHMARK_TEMPLATE(bm_select, Dibit64, DibitRankIndex<std::uint64_t>)->arg(1 << 30);
+BENCHMARK_TEMPLATE(bm_rank, Quadbit64, QuadbitRankIndex<std::uint64_t>)->arg(1 << 30);
+BENCHMARK_TEMPLATE(bm_select, Quadbit64, QuadbitRankIndex<std::uint64_t>)->arg(1 << 30);
+
+BENCHMARK_TEMPLATE(bm_load, Dibit64)->arg(1 << 28);
+BENCHMARK_TEMPLATE(bm_map, DibitMapping<std::uint64_t>)->arg(1 << 28);
+
+BENCHMARK_TEMPLATE(bm_fastx, Dibit8)->args({150, 0})->args({150, 1})->args({1 << 20, 0})->args(
+    {1 << 20, 1});
+
+BENCHMARK_TEMPLATE(bm_reads_malloc, Dibit8)->arg(1 << 20);
+BENCHMARK_TEMPLATE(bm_reads_arena, pmr::DibitVector<>)->arg(1 << 20);
+// 150 bases fit in 38 blocks.
+BENCHMARK_TEMPLATE(bm_reads_malloc, SmallDibitVector<40>)->arg(1 << 20);
+BENCHMARK_TEMPLATE(bm_reads_string_set, DibitStringSet<>)->arg(1 << 20);
+BENCHMARK_TEMPLATE(bm_reads_string_set, DibitStringSet<std::uint64_t>)->arg(1 << 20);
+
+// 1 GiB of dibits from 1 to 64 threads.
+#define XBIT_BENCHMARK_SCALING(fn)                          \
+  BENCHMARK_TEMPLATE(fn, Dibit64)->args_product({{std::int64_t{1} << 32}, {1, 2, 4, 8, 16, 32, 64}})
+
+XBIT_BENCHMARK_SCALING(bm_parallel_flip);
+XBIT_BENCHMARK_SCALING(bm_parallel_count);
+XBIT_BENCHMARK_SCALING(bm_parallel_reverse_complement);
+XBIT_BENCHMARK_SCALING(bm_parallel_pack_ascii);
+
+BENCHMARK_MAIN();
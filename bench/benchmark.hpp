@@ -0,0 +1,313 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+// A small self-contained subset of Google Benchmark, so the suite builds and runs offline.
+// Results are reported in the Google Benchmark console and JSON formats, which makes the JSON
+// output comparable with the usual tooling (e.g. compare.py).
+namespace bench {
+
+class State {
+ public:
+  using clock = std::chrono::steady_clock;
+
+  // Non-trivial so `for (auto _ : state)` does not trigger -Wunused-variable.
+  struct Value {
+    ~Value() {}
+  };
+
+  struct Iterator {
+    State* state;
+    std::size_t left;
+
+    bool operator!=(const Iterator&) {
+      if (left != 0) return true;
+      state->finish();
+      return false;
+    }
+
+    void operator++() { --left; }
+
+    Value operator*() const { return {}; }
+  };
+
+ private:
+  std::size_t iterations_;
+  std::vector<std::int64_t> args_;
+  clock::time_point start_{};
+  clock::duration elapsed_{};
+  bool running_ = false;
+  std::int64_t bytes_ = 0;
+  std::int64_t items_ = 0;
+  std::string label_;
+
+ public:
+  State(std::size_t iterations, std::vector<std::int64_t> args)
+      : iterations_(iterations), args_(std::move(args)) {}
+
+  Iterator begin() {
+    resume_timing();
+    return {this, iterations_};
+  }
+
+  Iterator end() { return {this, 0}; }
+
+  std::int64_t range(std::size_t i = 0) const { return i < args_.size() ? args_[i] : 0; }
+
+  std::size_t iterations() const { return iterations_; }
+
+  void pause_timing() {
+    if (running_) elapsed_ += clock::now() - start_;
+    running_ = false;
+  }
+
+  void resume_timing() {
+    start_ = clock::now();
+    running_ = true;
+  }
+
+  void set_bytes_processed(std::int64_t bytes) { bytes_ = bytes; }
+
+  void set_items_processed(std::int64_t items) { items_ = items; }
+
+  void set_label(std::string label) { label_ = std::move(label); }
+
+  double seconds() const { return std::chrono::duration<double>(elapsed_).count(); }
+
+  std::int64_t bytes_processed() const { return bytes_; }
+
+  std::int64_t items_processed() const { return items_; }
+
+  const std::string& label() const { return label_; }
+
+ private:
+  void finish() { pause_timing(); }
+};
+
+// Escapes the address of value, together with the memory clobber the compiler has to assume it
+// is read and cannot drop the computation producing it.
+template <typename T>
+inline void do_not_optimize(T&& value) {
+  asm volatile("" : : "g"(&value) : "memory");
+}
+
+inline void clobber_memory() { asm volatile("" : : : "memory"); }
+
+class Benchmark {
+  std::string name_;
+  std::function<void(State&)> fn_;
+  std::vector<std::vector<std::int64_t>> args_;
+
+ public:
+  Benchmark(std::string name, std::function<void(State&)> fn)
+      : name_(std::move(name)), fn_(std::move(fn)) {}
+
+  Benchmark* arg(std::int64_t x) {
+    args_.push_back({x});
+    return this;
+  }
+
+  Benchmark* args(std::vector<std::int64_t> xs) {
+    args_.push_back(std::move(xs));
+    return this;
+  }
+
+  // Powers of mult from lo to hi, both included.
+  Benchmark* range(std::int64_t lo, std::int64_t hi, std::int64_t mult = 8) {
+    for (auto x = lo; x < hi; x *= mult) args_.push_back({x});
+    args_.push_back({hi});
+    return this;
+  }
+
+  // Every combination of one value from each list, the last list varying fastest.
+  Benchmark* args_product(const std::vector<std::vector<std::int64_t>>& lists) {
+    std::vector<std::vector<std::int64_t>> product = {{}};
+    for (const auto& list : lists) {
+      std::vector<std::vector<std::int64_t>> next;
+      for (const auto& prefix : product)
+        for (auto x : list) {
+          next.push_back(prefix);
+          next.back().push_back(x);
+        }
+      product = std::move(next);
+    }
+    args_.insert(args_.end(), product.begin(), product.end());
+    return this;
+  }
+
+  const std::string& name() const { return name_; }
+
+  const std::vector<std::vector<std::int64_t>>& arguments() const { return args_; }
+
+  void run(State& state) const { fn_(state); }
+};
+
+inline std::vector<std::unique_ptr<Benchmark>>& registry() {
+  static std::vector<std::unique_ptr<Benchmark>> benchmarks;
+  return benchmarks;
+}
+
+inline Benchmark* register_benchmark(std::string name, std::function<void(State&)> fn) {
+  return registry().emplace_back(std::make_unique<Benchmark>(std::move(name), std::move(fn))).get();
+}
+
+struct Result {
+  std::string name;
+  std::size_t iterations;
+  double ns_per_iteration;
+  double bytes_per_second;
+  double items_per_second;
+  std::string label;
+};
+
+inline std::string json_escape(std::string_view s) {
+  std::string r;
+  for (char c : s) {
+    if (c == '"' || c == '\\') r += '\\';
+    r += c;
+  }
+  return r;
+}
+
+inline void write_json(std::FILE* out, const std::vector<Result>& results) {
+  char date[64];
+  const std::time_t now = std::time(nullptr);
+  std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+  std::fprintf(out, "{\n  \"context\": {\n");
+  std::fprintf(out, "    \"date\": \"%s\",\n", date);
+  std::fprintf(out, "    \"num_cpus\": %u,\n", std::thread::hardware_concurrency());
+#ifdef NDEBUG
+  std::fprintf(out, "    \"library_build_type\": \"release\"\n");
+#else
+  std::fprintf(out, "    \"library_build_type\": \"debug\"\n");
+#endif
+  std::fprintf(out, "  },\n  \"benchmarks\": [");
+  for (std::size_t i = 0; i < results.size(); ++i) {
+    const auto& r = results[i];
+    std::fprintf(out, "%s\n    {\n", i ? "," : "");
+    std::fprintf(out, "      \"name\": \"%s\",\n", json_escape(r.name).c_str());
+    std::fprintf(out, "      \"run_name\": \"%s\",\n", json_escape(r.name).c_str());
+    std::fprintf(out, "      \"run_type\": \"iteration\",\n");
+    std::fprintf(out, "      \"iterations\": %zu,\n", r.iterations);
+    std::fprintf(out, "      \"real_time\": %.6e,\n", r.ns_per_iteration);
+    std::fprintf(out, "      \"cpu_time\": %.6e,\n", r.ns_per_iteration);
+    std::fprintf(out, "      \"time_unit\": \"ns\"");
+    if (r.bytes_per_second > 0)
+      std::fprintf(out, ",\n      \"bytes_per_second\": %.6e", r.bytes_per_second);
+    if (r.items_per_second > 0)
+      std::fprintf(out, ",\n      \"items_per_second\": %.6e", r.items_per_second);
+    if (!r.label.empty())
+      std::fprintf(out, ",\n      \"label\": \"%s\"", json_escape(r.label).c_str());
+    std::fprintf(out, "\n    }");
+  }
+  std::fprintf(out, "\n  ]\n}\n");
+}
+
+inline void write_console_line(std::FILE* out, const Result& r) {
+  std::fprintf(out, "%-60s %14.1f ns %12zu", r.name.c_str(), r.ns_per_iteration, r.iterations);
+  if (r.bytes_per_second > 0)
+    std::fprintf(out, "  bytes_per_second=%.4gG/s", r.bytes_per_second / 1e9);
+  if (r.items_per_second > 0)
+    std::fprintf(out, "  items_per_second=%.4gM/s", r.items_per_second / 1e6);
+  if (!r.label.empty()) std::fprintf(out, "  %s", r.label.c_str());
+  std::fprintf(out, "\n");
+}
+
+inline Result run_one(const Benchmark& b, const std::string& name,
+                      const std::vector<std::int64_t>& args, double min_time) {
+  std::size_t iterations = 1;
+  while (true) {
+    State state(iterations, args);
+    b.run(state);
+    const double t = state.seconds();
+    if (t >= min_time || iterations >= 1'000'000'000) {
+      return {name,
+              iterations,
+              t * 1e9 / iterations,
+              state.bytes_processed() / std::max(t, 1e-12),
+              state.items_processed() / std::max(t, 1e-12),
+              state.label()};
+    }
+    // Same growth policy as Google Benchmark: aim for min_time with 40% slack, at most 10x.
+    const double multiplier = t <= 0 ? 10 : std::min(10.0, min_time * 1.4 / t);
+    iterations = std::max(iterations + 1, static_cast<std::size_t>(iterations * multiplier));
+  }
+}
+
+// Flags follow Google Benchmark: --benchmark_filter=<substring>, --benchmark_min_time=<seconds>,
+// --benchmark_format=<console|json> and --benchmark_out=<file> (always JSON).
+inline int run_benchmarks(int argc, char** argv) {
+  std::string filter;
+  std::string out_path;
+  bool json = false;
+  double min_time = 0.5;
+  for (int i = 1; i < argc; ++i) {
+    const std::string_view a = argv[i];
+    auto value = [&](std::string_view flag) { return a.substr(flag.size()); };
+    if (a.starts_with("--benchmark_filter=")) filter = value("--benchmark_filter=");
+    else if (a.starts_with("--benchmark_min_time="))
+      min_time = std::stod(std::string(value("--benchmark_min_time=")));
+    else if (a.starts_with("--benchmark_format="))
+      json = value("--benchmark_format=") == "json";
+    else if (a.starts_with("--benchmark_out="))
+      out_path = value("--benchmark_out=");
+    else {
+      std::fprintf(stderr, "unrecognized argument: %s\n", argv[i]);
+      return 1;
+    }
+  }
+
+  std::vector<Result> results;
+  for (const auto& b : registry()) {
+    auto args = b->arguments();
+    if (args.empty()) args.emplace_back();
+    for (const auto& a : args) {
+      std::string name = b->name();
+      for (auto x : a) {
+        name += '/';
+        name += std::to_string(x);
+      }
+      if (name.find(filter) == std::string::npos) continue;
+      results.push_back(run_one(*b, name, a, min_time));
+      if (!json) write_console_line(stdout, results.back());
+    }
+  }
+  if (json) write_json(stdout, results);
+  if (!out_path.empty()) {
+    std::FILE* f = std::fopen(out_path.c_str(), "w");
+    if (f == nullptr) {
+      std::fprintf(stderr, "cannot open %s\n", out_path.c_str());
+      return 1;
+    }
+    write_json(f, results);
+    std::fclose(f);
+  }
+  return 0;
+}
+
+}  // namespace bench
+
+#define BENCHMARK_CONCAT_(a, b) a##b
+#define BENCHMARK_CONCAT(a, b) BENCHMARK_CONCAT_(a, b)
+
+#define BENCHMARK(fn)                                                                \
+  [[maybe_unused]] static ::bench::Benchmark* BENCHMARK_CONCAT(bench_reg_, __COUNTER__) = \
+      ::bench::register_benchmark(#fn, fn)
+
+#define BENCHMARK_TEMPLATE(fn, ...)                                                  \
+  [[maybe_unused]] static ::bench::Benchmark* BENCHMARK_CONCAT(bench_reg_, __COUNTER__) = \
+      ::bench::register_benchmark(#fn "<" #__VA_ARGS__ ">", fn<__VA_ARGS__>)
+
+#define BENCHMARK_MAIN() \
+  int main(int argc, char** argv) { return ::bench::run_benchmarks(argc, argv); }
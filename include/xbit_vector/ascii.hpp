@@ -0,0 +1,344 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <string_view>
+
+#include "xbit_vector.hpp"
+
+namespace biomodern::detail {
+
+// Nucleotides are packed as A = 0, C = 1, G = 2, T = 3 into DibitVector and with the usual
+// 4-bit IUPAC encoding "=ACMGRSVTWYHKDBN" (one bit per base, as in BAM) into QuadbitVector.
+// Upper and lower case are both accepted, characters outside the alphabet are packed as A
+// (resp. N) and counted, the pack functions return that count.
+
+constexpr std::string_view dibit_chars = "ACGT";
+
+constexpr std::uint8_t invalid_code = 0x10;
+
+constexpr std::array<std::uint8_t, 256> dibit_codes = [] {
+  std::array<std::uint8_t, 256> t{};
+  t.fill(invalid_code);
+  for (std::size_t x = 0; x < 4; ++x) {
+    t[static_cast<unsigned char>("ACGT"[x])] = static_cast<std::uint8_t>(x);
+    t[static_cast<unsigned char>("acgt"[x])] = static_cast<std::uint8_t>(x);
+  }
+  return t;
+}();
+
+constexpr std::string_view iupac_chars = "=ACMGRSVTWYHKDBN";
+
+constexpr std::array<std::uint8_t, 256> iupac_codes = [] {
+  std::array<std::uint8_t, 256> t{};
+  t.fill(invalid_code | 15);
+  for (std::size_t x = 0; x < iupac_chars.size(); ++x) {
+    t[static_cast<unsigned char>(iupac_chars[x])] = static_cast<std::uint8_t>(x);
+    t[static_cast<unsigned char>(iupac_chars[x] | 0x20)] = static_cast<std::uint8_t>(x);
+  }
+  t['='] = t['-'] = 0;
+  t['U'] = t['u'] = 8;
+  return t;
+}();
+
+#if defined(__SSSE3__)
+// Indexed by the low nibble of an ASCII letter, A = 0x41, C = 0x43, G = 0x47 and T = 0x54.
+inline __m128i dibit_nibble_codes() noexcept {
+  return _mm_setr_epi8(0, 0, 0, 1, 3, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0);
+}
+
+// Indexed by a dibit shifted left by 0 or 2, see unpack_dibits16.
+inline __m128i dibit_nibble_chars() noexcept {
+  return _mm_setr_epi8('A', 'C', 'G', 'T', 'C', 0, 0, 0, 'G', 0, 0, 0, 'T', 0, 0, 0);
+}
+
+// Low nibble of the upper-cased letter to its code for 0x40-0x4f and 0x50-0x5f, 0x1f stands for
+// an invalid N.
+inline __m128i iupac_codes_4x() noexcept {
+  return _mm_setr_epi8(0x1f, 1, 14, 2, 13, 0x1f, 0x1f, 4, 11, 0x1f, 0x1f, 12, 0x1f, 3, 15, 0x1f);
+}
+
+inline __m128i iupac_codes_5x() noexcept {
+  return _mm_setr_epi8(
+      0x1f, 0x1f, 5, 6, 8, 8, 7, 9, 0x1f, 10, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f, 0x1f);
+}
+
+inline __m128i iupac_table() noexcept {
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(iupac_chars.data()));
+}
+
+// Encode 16 characters to 16 dibits, the count of invalid characters is added to invalid.
+inline std::uint32_t pack_dibits16(const char* s, std::size_t& invalid) noexcept {
+  const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+  const __m128i lower = _mm_or_si128(c, _mm_set1_epi8(0x20));
+  const __m128i valid = _mm_or_si128(
+      _mm_or_si128(
+          _mm_cmpeq_epi8(lower, _mm_set1_epi8('a')), _mm_cmpeq_epi8(lower, _mm_set1_epi8('c'))),
+      _mm_or_si128(
+          _mm_cmpeq_epi8(lower, _mm_set1_epi8('g')), _mm_cmpeq_epi8(lower, _mm_set1_epi8('t'))));
+  invalid += 16 - std::popcount(static_cast<unsigned>(_mm_movemask_epi8(valid)));
+  const __m128i codes = _mm_and_si128(
+      _mm_shuffle_epi8(dibit_nibble_codes(), _mm_and_si128(c, _mm_set1_epi8(0x0f))), valid);
+  const __m128i pairs = _mm_maddubs_epi16(codes, _mm_set1_epi16(0x0401));
+  const __m128i quads = _mm_madd_epi16(pairs, _mm_set1_epi32(0x00100001));
+  const __m128i bytes = _mm_shuffle_epi8(
+      quads, _mm_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+  return static_cast<std::uint32_t>(_mm_cvtsi128_si32(bytes));
+}
+
+inline void unpack_dibits16(std::uint32_t x, char* out) noexcept {
+  const __m128i v = _mm_shuffle_epi8(
+      _mm_set1_epi32(static_cast<int>(x)),
+      _mm_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3));
+  const __m128i t = _mm_and_si128(v, _mm_set1_epi32(static_cast<int>(0xc0300c03)));
+  const __m128i n = _mm_and_si128(_mm_or_si128(t, _mm_srli_epi16(t, 4)), _mm_set1_epi8(0x0f));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(dibit_nibble_chars(), n));
+}
+
+// Encode 16 characters to 16 quadbits.
+inline std::uint64_t pack_quadbits16(const char* s, std::size_t& invalid) noexcept {
+  const __m128i c = _mm_loadu_si128(reinterpret_cast<const __m128i*>(s));
+  const __m128i upper = _mm_andnot_si128(_mm_set1_epi8(0x20), c);
+  const __m128i low = _mm_set1_epi8(0x0f);
+  const __m128i lo = _mm_and_si128(upper, low);
+  const __m128i hi = _mm_and_si128(_mm_srli_epi16(upper, 4), low);
+  const __m128i is4 = _mm_cmpeq_epi8(hi, _mm_set1_epi8(4));
+  const __m128i is5 = _mm_cmpeq_epi8(hi, _mm_set1_epi8(5));
+  const __m128i gap =
+      _mm_or_si128(_mm_cmpeq_epi8(c, _mm_set1_epi8('-')), _mm_cmpeq_epi8(c, _mm_set1_epi8('=')));
+  __m128i codes = _mm_or_si128(
+      _mm_and_si128(is4, _mm_shuffle_epi8(iupac_codes_4x(), lo)),
+      _mm_and_si128(is5, _mm_shuffle_epi8(iupac_codes_5x(), lo)));
+  codes = _mm_or_si128(
+      codes, _mm_andnot_si128(_mm_or_si128(_mm_or_si128(is4, is5), gap), _mm_set1_epi8(0x1f)));
+  invalid += std::popcount(static_cast<unsigned>(_mm_movemask_epi8(_mm_slli_epi16(codes, 3))));
+  const __m128i pairs = _mm_maddubs_epi16(_mm_and_si128(codes, low), _mm_set1_epi16(0x1001));
+  return static_cast<std::uint64_t>(_mm_cvtsi128_si64(_mm_packus_epi16(pairs, pairs)));
+}
+
+inline void unpack_quadbits16(std::uint64_t x, char* out) noexcept {
+  const __m128i b = _mm_cvtsi64_si128(static_cast<long long>(x));
+  const __m128i low = _mm_set1_epi8(0x0f);
+  const __m128i n =
+      _mm_unpacklo_epi8(_mm_and_si128(b, low), _mm_and_si128(_mm_srli_epi16(b, 4), low));
+  _mm_storeu_si128(reinterpret_cast<__m128i*>(out), _mm_shuffle_epi8(iupac_table(), n));
+}
+#endif
+
+#if defined(__AVX2__)
+inline std::uint64_t pack_dibits32(const char* s, std::size_t& invalid) noexcept {
+  const __m256i c = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(s));
+  const __m256i lower = _mm256_or_si256(c, _mm256_set1_epi8(0x20));
+  const __m256i valid = _mm256_or_si256(
+      _mm256_or_si256(
+          _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('a')),
+          _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('c'))),
+      _mm256_or_si256(
+          _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('g')),
+          _mm256_cmpeq_epi8(lower, _mm256_set1_epi8('t'))));
+  invalid += 32 - std::popcount(static_cast<unsigned>(_mm256_movemask_epi8(valid)));
+  const __m256i codes = _mm256_and_si256(
+      _mm256_shuffle_epi8(
+          _mm256_broadcastsi128_si256(dibit_nibble_codes()),
+          _mm256_and_si256(c, _mm256_set1_epi8(0x0f))),
+      valid);
+  const __m256i pairs = _mm256_maddubs_epi16(codes, _mm256_set1_epi16(0x0401));
+  const __m256i quads = _mm256_madd_epi16(pairs, _mm256_set1_epi32(0x00100001));
+  const __m256i bytes = _mm256_shuffle_epi8(
+      quads, _mm256_setr_epi8(0, 4, 8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, 0, 4,
+                              8, 12, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1));
+  return static_cast<std::uint32_t>(_mm256_extract_epi32(bytes, 0)) |
+         std::uint64_t{static_cast<std::uint32_t>(_mm256_extract_epi32(bytes, 4))} << 32;
+}
+
+inline void unpack_dibits32(std::uint64_t x, char* out) noexcept {
+  const __m256i v = _mm256_shuffle_epi8(
+      _mm256_set1_epi64x(static_cast<long long>(x)),
+      _mm256_setr_epi8(0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 6,
+                       6, 6, 6, 7, 7, 7, 7));
+  const __m256i t = _mm256_and_si256(v, _mm256_set1_epi32(static_cast<int>(0xc0300c03)));
+  const __m256i n = _mm256_and_si256(
+      _mm256_or_si256(t, _mm256_srli_epi16(t, 4)), _mm256_set1_epi8(0x0f));
+  _mm256_storeu_si256(
+      reinterpret_cast<__m256i*>(out),
+      _mm256_shuffle_epi8(_mm256_broadcastsi128_si256(dibit_nibble_chars()), n));
+}
+#endif
+
+// Portable fallbacks, 32 dibits or 16 quadbits per 64-bit word.
+inline std::uint64_t pack_dibits32_scalar(const char* s, std::size_t& invalid) noexcept {
+  std::uint64_t w = 0;
+  for (std::size_t i = 0; i < 32; ++i) {
+    const std::uint8_t x = dibit_codes[static_cast<unsigned char>(s[i])];
+    invalid += x >> 4;
+    w |= std::uint64_t{x & 3u} << (2 * i);
+  }
+  return w;
+}
+
+inline std::uint64_t pack_quadbits16_scalar(const char* s, std::size_t& invalid) noexcept {
+  std::uint64_t w = 0;
+  for (std::size_t i = 0; i < 16; ++i) {
+    const std::uint8_t x = iupac_codes[static_cast<unsigned char>(s[i])];
+    invalid += x >> 4;
+    w |= std::uint64_t{x & 15u} << (4 * i);
+  }
+  return w;
+}
+
+inline std::uint64_t pack_word(
+    const char* s, std::size_t& invalid, std::integral_constant<std::size_t, 2>) noexcept {
+#if defined(__AVX2__)
+  return pack_dibits32(s, invalid);
+#elif defined(__SSSE3__)
+  return pack_dibits16(s, invalid) | std::uint64_t{pack_dibits16(s + 16, invalid)} << 32;
+#else
+  return pack_dibits32_scalar(s, invalid);
+#endif
+}
+
+inline std::uint64_t pack_word(
+    const char* s, std::size_t& invalid, std::integral_constant<std::size_t, 4>) noexcept {
+#if defined(__SSSE3__)
+  return pack_quadbits16(s, invalid);
+#else
+  return pack_quadbits16_scalar(s, invalid);
+#endif
+}
+
+inline void unpack_word(
+    std::uint64_t w, char* out, std::integral_constant<std::size_t, 2>) noexcept {
+#if defined(__AVX2__)
+  unpack_dibits32(w, out);
+#elif defined(__SSSE3__)
+  unpack_dibits16(static_cast<std::uint32_t>(w), out);
+  unpack_dibits16(static_cast<std::uint32_t>(w >> 32), out + 16);
+#else
+  for (std::size_t i = 0; i < 32; ++i) out[i] = dibit_chars[w >> (2 * i) & 3];
+#endif
+}
+
+inline void unpack_word(
+    std::uint64_t w, char* out, std::integral_constant<std::size_t, 4>) noexcept {
+#if defined(__SSSE3__)
+  unpack_quadbits16(w, out);
+#else
+  for (std::size_t i = 0; i < 16; ++i) out[i] = iupac_chars[w >> (4 * i) & 15];
+#endif
+}
+
+template <std::size_t N>
+constexpr const std::array<std::uint8_t, 256>& ascii_codes() noexcept {
+  if constexpr (N == 2) return dibit_codes;
+  else
+    return iupac_codes;
+}
+
+template <std::size_t N>
+constexpr std::string_view ascii_chars() noexcept {
+  if constexpr (N == 2) return dibit_chars;
+  else
+    return iupac_chars;
+}
+
+// Encode s into [out, out + s.size()), a 64-bit word of codes at a time.
+template <std::size_t N, std::unsigned_integral Block>
+requires(N == 2 || N == 4) std::size_t
+    pack_ascii(std::string_view s, XbitIterator<N, Block> out) noexcept {
+  constexpr std::size_t per_word = 64 / N;
+  std::size_t invalid = 0;
+  const char* p = s.data();
+  const std::size_t pos = out.bit_offset();
+  std::size_t i = 0;
+  for (; i + per_word <= s.size(); i += per_word)
+    store_bits64(
+        out.segment(), pos + i * N, 64,
+        pack_word(p + i, invalid, std::integral_constant<std::size_t, N>{}));
+  for (out += i; i < s.size(); ++i, ++out) {
+    const std::uint8_t x = ascii_codes<N>()[static_cast<unsigned char>(p[i])];
+    invalid += x >> 4;
+    *out = x;
+  }
+  return invalid;
+}
+
+// Decode [first, last) to last - first characters at out.
+template <std::size_t N, std::unsigned_integral Block>
+requires(N == 2 || N == 4) char* unpack_ascii(
+    XbitConstIterator<N, Block> first, XbitConstIterator<N, Block> last, char* out) noexcept {
+  constexpr std::size_t per_word = 64 / N;
+  const std::size_t n = last - first;
+  const std::size_t pos = first.bit_offset();
+  std::size_t i = 0;
+  for (; i + per_word <= n; i += per_word, out += per_word)
+    unpack_word(
+        load_bits64(first.segment(), pos + i * N, 64), out,
+        std::integral_constant<std::size_t, N>{});
+  for (first += i; first != last; ++first) *out++ = ascii_chars<N>()[*first];
+  return out;
+}
+
+template <std::size_t N, std::unsigned_integral Block>
+requires(N == 2 || N == 4) char* unpack_ascii(
+    XbitIterator<N, Block> first, XbitIterator<N, Block> last, char* out) noexcept {
+  return unpack_ascii(XbitConstIterator<N, Block>(first), XbitConstIterator<N, Block>(last), out);
+}
+
+}  // namespace biomodern::detail
+
+namespace biomodern {
+
+// Append the bases of s to v, returns the number of characters which are not A, C, G or T.
+template <std::unsigned_integral Block, std::copy_constructible Allocator, std::size_t InlineBlocks>
+std::size_t pack_ascii(std::string_view s, SmallDibitVector<InlineBlocks, Block, Allocator>& v) {
+  const auto old_size = v.size();
+  v.resize(old_size + s.size());
+  return detail::pack_ascii(s, v.begin() + old_size);
+}
+
+// Write the v.size() bases of v to out.
+template <std::unsigned_integral Block, std::copy_constructible Allocator, std::size_t InlineBlocks>
+char* unpack_ascii(
+    const SmallDibitVector<InlineBlocks, Block, Allocator>& v, char* out) noexcept {
+  return detail::unpack_ascii(v.begin(), v.end(), out);
+}
+
+// Append the IUPAC codes of s to v, returns the number of characters which are not IUPAC codes,
+// those are packed as N.
+template <std::unsigned_integral Block, std::copy_constructible Allocator, std::size_t InlineBlocks>
+std::size_t pack_iupac(std::string_view s, SmallQuadbitVector<InlineBlocks, Block, Allocator>& v) {
+  const auto old_size = v.size();
+  v.resize(old_size + s.size());
+  return detail::pack_ascii(s, v.begin() + old_size);
+}
+
+template <std::unsigned_integral Block, std::copy_constructible Allocator, std::size_t InlineBlocks>
+char* unpack_iupac(
+    const SmallQuadbitVector<InlineBlocks, Block, Allocator>& v, char* out) noexcept {
+  return detail::unpack_ascii(v.begin(), v.end(), out);
+}
+
+// Overwrite the first s.size() <= v.size() xbits of v, returns the number of invalid characters.
+template <typename Block>
+requires(!std::is_const_v<Block>) std::size_t pack_ascii(std::string_view s, DibitSpan<Block> v) {
+  assert(s.size() <= v.size());
+  return detail::pack_ascii(s, v.begin());
+}
+
+template <typename Block>
+char* unpack_ascii(DibitSpan<Block> v, char* out) noexcept {
+  return detail::unpack_ascii(v.begin(), v.end(), out);
+}
+
+template <typename Block>
+requires(!std::is_const_v<Block>) std::size_t pack_iupac(std::string_view s, QuadbitSpan<Block> v) {
+  assert(s.size() <= v.size());
+  return detail::pack_ascii(s, v.begin());
+}
+
+template <typename Block>
+char* unpack_iupac(QuadbitSpan<Block> v, char* out) noexcept {
+  return detail::unpack_ascii(v.begin(), v.end(), out);
+}
+
+}  // namespace biomodern
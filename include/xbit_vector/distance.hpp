@@ -0,0 +1,325 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <concepts>
+#include <limits>
+#include <vector>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+#include "xbit_vector.hpp"
+
+namespace biomodern::detail {
+
+// XbitVector, XbitSpan and the like, whose iterators locate xbits by block and bit offset.
+template <typename R>
+concept xbit_sequence = requires {
+  typename R::const_iterator::Base;
+} && std::derived_from<typename R::const_iterator, typename R::const_iterator::Base>;
+
+// Number of xbits which differ between the n bits starting at bit ao of a and at bit bo of b,
+// returned as soon as it exceeds limit. Both sides are read 64 bits at a time at whatever offset
+// they start, so ranges which are not congruent within a block are shifted on the fly. The XOR
+// of the two words is folded to one bit per xbit and popcounted.
+template <std::size_t N, std::unsigned_integral B1, std::unsigned_integral B2>
+requires(64 % N == 0) constexpr std::size_t mismatch_count_bits(
+    const B1* a, std::size_t ao, const B2* b, std::size_t bo, std::size_t n,
+    std::size_t limit) noexcept {
+  constexpr std::uint64_t ones = replicate<N, std::uint64_t>(1);
+  std::size_t r = 0, i = 0;
+  for (; i + 64 <= n; i += 64) {
+    const std::uint64_t d = load_bits64(a, ao + i, 64) ^ load_bits64(b, bo + i, 64);
+    r += static_cast<std::size_t>(std::popcount(fold_lanes<N>(d) & ones));
+    if (r > limit) return r;
+  }
+  if (i < n) {
+    const std::uint64_t d = load_bits64(a, ao + i, n - i) ^ load_bits64(b, bo + i, n - i);
+    r += static_cast<std::size_t>(std::popcount(fold_lanes<N>(d) & ones));
+  }
+  return r;
+}
+
+template <std::size_t N, std::unsigned_integral B1, std::unsigned_integral B2>
+constexpr std::size_t mismatch_count(
+    const XbitIteratorBase<N, B1>& first1, std::size_t n, const XbitIteratorBase<N, B2>& first2,
+    std::size_t limit) noexcept {
+  return mismatch_count_bits<N>(
+      first1.segment(), first1.bit_offset(), first2.segment(), first2.bit_offset(), n * N, limit);
+}
+
+template <typename Base>
+constexpr std::size_t xbit_width = 0;
+
+template <std::size_t N, typename Block>
+constexpr std::size_t xbit_width<XbitIteratorBase<N, Block>> = N;
+
+// Vectors and spans of xbits of width N.
+template <typename R, std::size_t N>
+concept xbit_sequence_of = xbit_sequence<R> && xbit_width<typename R::const_iterator::Base> == N;
+
+// Gather the low bit of every xbit of x into the low 64 / N bits, PEXT does it in one step.
+template <std::size_t N>
+constexpr std::uint64_t compress_lanes(std::uint64_t x) noexcept {
+  constexpr std::uint64_t ones = replicate<N, std::uint64_t>(1);
+  x &= ones;
+  if constexpr (N == 1) return x;
+  else {
+#if defined(__BMI2__)
+    if (!std::is_constant_evaluated()) return _pext_u64(x, ones);
+#endif
+    // Groups of s bits every s * N bits are merged pairwise into groups of 2s bits.
+    for (std::size_t s = 1; s < 64 / N; s *= 2) {
+      std::uint64_t m = 0;
+      for (std::size_t i = 0; i < 64; i += 2 * s * N) m |= low_mask<std::uint64_t>(2 * s) << i;
+      x = (x | x >> (s * (N - 1))) & m;
+    }
+    return x;
+  }
+}
+
+// One column of Myers' algorithm over 64 rows whose vertical deltas are +1 where pv is set and -1
+// where mv is set. eq has the rows matching the text symbol, hin is the horizontal delta entering
+// at the top and high selects the bottom row, the horizontal delta leaving it is returned.
+constexpr int advance_block(
+    std::uint64_t& pv, std::uint64_t& mv, std::uint64_t eq, int hin, std::uint64_t high) noexcept {
+  const std::uint64_t xv = eq | mv;
+  eq |= std::uint64_t{hin < 0};
+  const std::uint64_t xh = (((eq & pv) + pv) ^ pv) | eq;
+  std::uint64_t ph = mv | ~(xh | pv);
+  std::uint64_t mh = pv & xh;
+  const int hout = int{(ph & high) != 0} - int{(mh & high) != 0};
+  ph = ph << 1 | std::uint64_t{hin > 0};
+  mh = mh << 1 | std::uint64_t{hin < 0};
+  pv = mh | ~(xv | ph);
+  mv = ph & xv;
+  return hout;
+}
+
+// Call f(i, x) for the n xbits x from first, which are read 64 bits at a time.
+template <std::size_t N, std::unsigned_integral Block, typename F>
+constexpr void for_each_xbit(const XbitIteratorBase<N, Block>& first, std::size_t n, F f) {
+  constexpr std::size_t per_word = 64 / N;
+  for (std::size_t i = 0; i < n; i += per_word) {
+    const std::size_t c = std::min(per_word, n - i);
+    std::uint64_t w = load_bits64(first.segment(), first.bit_offset() + i * N, c * N);
+    for (std::size_t j = 0; j < c; ++j, w >>= N)
+      f(i + j, static_cast<std::size_t>(w & low_mask<std::uint64_t>(N)));
+  }
+}
+
+// A pattern prepared for Myers' bit-vector edit distance (as formulated by Hyyrö). Every symbol
+// has a bitmask of the pattern positions holding it, built from the packed blocks by comparing 64
+// bits at a time and gathering the matching lanes. Patterns longer than 64 are split into words
+// of 64 rows processed from top to bottom, a text symbol then costs one step per word which may
+// hold a cell within the distance sought.
+template <std::size_t N>
+requires(N == 1 || N == 2 || N == 4) class MyersPattern {
+ public:
+  typedef std::size_t size_type;
+
+  constexpr static size_type sigma = size_type{1} << N;
+
+ private:
+  size_type size_ = 0, words_ = 0;
+  // peq_[c * words_ + w] has bit i set when the pattern holds c at 64 * w + i.
+  std::vector<std::uint64_t> peq_;
+
+  // The last row of word w, counted from 1.
+  constexpr size_type bottom(size_type w) const noexcept { return std::min(64 * (w + 1), size_); }
+
+  constexpr std::uint64_t high(size_type w) const noexcept {
+    return std::uint64_t{1} << ((w + 1 == words_ ? size_ - 1 : 63) % 64);
+  }
+
+ public:
+  MyersPattern() = default;
+
+  template <xbit_sequence_of<N> P>
+  explicit MyersPattern(const P& pattern);
+
+  constexpr size_type size() const noexcept { return size_; }
+
+  // Call f(end, distance) for every end (one past the last symbol) of a substring of text within
+  // edit distance k of the pattern, in increasing order of end.
+  template <xbit_sequence_of<N> T, typename F>
+  void search(const T& text, size_type k, F f) const;
+
+  // Edit distance between the pattern and text, or band + 1 if it exceeds band. Only the cells
+  // within band of the diagonal are computed, i.e. about 2 * band / 64 + 1 words per symbol.
+  template <xbit_sequence_of<N> T>
+  size_type distance(const T& text, size_type band = std::numeric_limits<size_type>::max()) const;
+};
+
+template <std::size_t N>
+requires(N == 1 || N == 2 || N == 4)
+template <xbit_sequence_of<N> P>
+MyersPattern<N>::MyersPattern(const P& pattern)
+    : size_(pattern.size()), words_((size_ + 63) / 64), peq_(sigma * words_) {
+  constexpr size_type per_word = 64 / N;
+  const auto first = pattern.cbegin();
+  for (size_type i = 0; i < size_; i += per_word) {
+    const size_type n = std::min(per_word, size_ - i);
+    const std::uint64_t w = load_bits64(first.segment(), first.bit_offset() + i * N, n * N);
+    for (size_type c = 0; c < sigma; ++c) {
+      const std::uint64_t x = w ^ replicate<N, std::uint64_t>(static_cast<std::uint8_t>(c));
+      peq_[c * words_ + i / 64] |=
+          (compress_lanes<N>(zero_lanes<N>(x)) & low_mask<std::uint64_t>(n)) << i % 64;
+    }
+  }
+}
+
+template <std::size_t N>
+requires(N == 1 || N == 2 || N == 4)
+template <xbit_sequence_of<N> T, typename F>
+void MyersPattern<N>::search(const T& text, size_type k, F f) const {
+  const auto n = text.size();
+  if (words_ == 0) {
+    for (size_type j = 0; j <= n; ++j) f(j, size_type{0});
+    return;
+  }
+  if (size_ <= k) f(size_type{0}, size_);
+  // Row 0 is all zeros since a match may start anywhere, nothing enters the top word.
+  std::vector<std::uint64_t> pv(words_, ~std::uint64_t{0}), mv(words_);
+  if (words_ == 1) {
+    auto score = size_;
+    const auto h = high(0);
+    for_each_xbit(text.cbegin(), n, [&](size_type j, size_type c) {
+      score += static_cast<size_type>(advance_block(pv[0], mv[0], peq_[c], 0, h));
+      if (score <= k) f(j + 1, score);
+    });
+    return;
+  }
+  // Ukkonen's cutoff: only the words down to the last one holding a cell within k are computed.
+  // A word joining them starts from the +1 deltas, which overestimates only cells beyond k.
+  std::vector<size_type> score(words_);
+  for (size_type w = 0; w < words_; ++w) score[w] = bottom(w);
+  size_type y = std::min(words_ - 1, k / 64);
+  for_each_xbit(text.cbegin(), n, [&](size_type j, size_type c) {
+    const std::uint64_t* eq = peq_.data() + c * words_;
+    int hin = 0;
+    for (size_type w = 0; w <= y; ++w) {
+      hin = advance_block(pv[w], mv[w], eq[w], hin, high(w));
+      score[w] += static_cast<size_type>(hin);
+    }
+    if (y + 1 < words_ && std::min(score[y], score[y] - static_cast<size_type>(hin)) <= k) {
+      const auto prev = score[y] - static_cast<size_type>(hin);
+      ++y;
+      pv[y] = ~std::uint64_t{0};
+      mv[y] = 0;
+      score[y] = prev + bottom(y) - bottom(y - 1) +
+                 static_cast<size_type>(advance_block(pv[y], mv[y], eq[y], hin, high(y)));
+    }
+    while (y > 0 && score[y] >= k + bottom(y) - bottom(y - 1)) --y;
+    if (y + 1 == words_ && score[y] <= k) f(j + 1, score[y]);
+  });
+}
+
+template <std::size_t N>
+requires(N == 1 || N == 2 || N == 4)
+template <xbit_sequence_of<N> T>
+typename MyersPattern<N>::size_type MyersPattern<N>::distance(
+    const T& text, size_type band) const {
+  const auto m = size_, n = text.size();
+  if (std::max(m, n) - std::min(m, n) > band) return band + 1;
+  if (words_ == 0) return n;
+  // No path costs more than max(m, n), wider bands change nothing.
+  const auto b = std::min(band, std::max(m, n));
+  // Cells more than band off the diagonal exceed band, and so cannot lie on a path of cost up to
+  // band. The words above the band are dropped and the one below them is fed +1 at the top, the
+  // words below the band start with the +1 deltas of column 0. Both overestimate only cells which
+  // exceed band anyway. score[w] is the value of the bottom row of word w.
+  std::vector<std::uint64_t> pv(words_, ~std::uint64_t{0}), mv(words_);
+  std::vector<size_type> score(words_);
+  size_type lo = 0, hi = 0;
+  for_each_xbit(text.cbegin(), n, [&](size_type j, size_type c) {
+    ++j;
+    for (; hi < words_ && 64 * hi <= j + b; ++hi)
+      score[hi] = hi == 0 ? bottom(0) : score[hi - 1] + bottom(hi) - bottom(hi - 1);
+    while (j > b && bottom(lo) < j - b) ++lo;
+    const std::uint64_t* eq = peq_.data() + c * words_;
+    int hin = 1;
+    for (size_type w = lo; w < hi; ++w) {
+      hin = advance_block(pv[w], mv[w], eq[w], hin, high(w));
+      score[w] += static_cast<size_type>(hin);
+    }
+  });
+  const auto d = n == 0 ? m : score[words_ - 1];
+  return d > band ? band + 1 : d;
+}
+
+}  // namespace biomodern::detail
+
+namespace biomodern {
+
+// Number of positions where [first1, last1) and the range from first2 differ.
+template <typename I1, typename I2>
+requires std::derived_from<I1, typename I1::Base> && std::derived_from<I2, typename I2::Base>
+constexpr std::size_t hamming(I1 first1, I1 last1, I2 first2) noexcept {
+  return detail::mismatch_count(
+      first1, last1 - first1, first2, std::numeric_limits<std::size_t>::max());
+}
+
+// Same but stops counting past k, the result is then k + 1. Seed verification rejects most
+// candidates within a word or two this way.
+template <typename I1, typename I2>
+requires std::derived_from<I1, typename I1::Base> && std::derived_from<I2, typename I2::Base>
+constexpr std::size_t hamming_at_most(I1 first1, I1 last1, I2 first2, std::size_t k) noexcept {
+  const auto r = detail::mismatch_count(first1, last1 - first1, first2, k);
+  return r > k ? k + 1 : r;
+}
+
+// Number of i < len where a[a_pos + i] != b[b_pos + i], for vectors and spans of equal widths.
+template <detail::xbit_sequence A, detail::xbit_sequence B>
+constexpr std::size_t hamming(
+    const A& a, std::size_t a_pos, const B& b, std::size_t b_pos, std::size_t len) noexcept {
+  assert(a_pos + len <= a.size() && b_pos + len <= b.size());
+  return hamming(a.cbegin() + a_pos, a.cbegin() + (a_pos + len), b.cbegin() + b_pos);
+}
+
+template <detail::xbit_sequence A, detail::xbit_sequence B>
+constexpr std::size_t hamming_at_most(
+    const A& a, std::size_t a_pos, const B& b, std::size_t b_pos, std::size_t len,
+    std::size_t k) noexcept {
+  assert(a_pos + len <= a.size() && b_pos + len <= b.size());
+  return hamming_at_most(a.cbegin() + a_pos, a.cbegin() + (a_pos + len), b.cbegin() + b_pos, k);
+}
+
+template <std::size_t N>
+using MyersPattern = detail::MyersPattern<N>;
+
+using DibitMyersPattern = detail::MyersPattern<2>;
+
+using QuadbitMyersPattern = detail::MyersPattern<4>;
+
+struct ApproximateMatch {
+  std::size_t end;
+  std::size_t distance;
+
+  constexpr bool operator==(const ApproximateMatch&) const noexcept = default;
+};
+
+// The ends of the substrings of text within edit distance k of pattern, see MyersPattern.
+template <detail::xbit_sequence P, detail::xbit_sequence T>
+std::vector<ApproximateMatch> approximate_matches(const P& pattern, const T& text, std::size_t k) {
+  constexpr auto N = detail::xbit_width<typename P::const_iterator::Base>;
+  std::vector<ApproximateMatch> r;
+  MyersPattern<N>(pattern).search(text, k, [&](std::size_t end, std::size_t d) {
+    r.push_back({end, d});
+  });
+  return r;
+}
+
+// Levenshtein distance between a and b, or band + 1 if it is larger than band.
+template <detail::xbit_sequence A, detail::xbit_sequence B>
+std::size_t edit_distance(
+    const A& a, const B& b, std::size_t band = std::numeric_limits<std::size_t>::max()) {
+  constexpr auto N = detail::xbit_width<typename A::const_iterator::Base>;
+  return MyersPattern<N>(a).distance(b, band);
+}
+
+}  // namespace biomodern
@@ -0,0 +1,399 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <istream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if __has_include(<unistd.h>)
+#include <cerrno>
+#include <unistd.h>
+#endif
+
+#include "ascii.hpp"
+
+namespace biomodern::detail {
+
+// One FASTA or FASTQ record. Characters other than ACGT are packed as A and the [first, last)
+// runs of their positions are listed in ambiguous, qual is empty for FASTA.
+template <std::unsigned_integral Block>
+struct FastxRecord {
+  std::string name;
+  DibitVector<Block> seq;
+  std::vector<std::pair<std::size_t, std::size_t>> ambiguous;
+  std::string qual;
+
+  void clear() noexcept {
+    name.clear();
+    seq.clear();
+    ambiguous.clear();
+    qual.clear();
+  }
+};
+
+struct FastxOptions {
+  // Bytes read from the input at once, and handed to the packing thread at once.
+  std::size_t chunk_size = std::size_t{1} << 20;
+  // Read and split the input on a second thread while the calling thread packs the bases.
+  bool pipelined = false;
+  // Chunks in flight between the two threads.
+  std::size_t queue_depth = 4;
+};
+
+// Append the bases of s to seq and the runs of characters other than ACGT to ambiguous.
+template <std::unsigned_integral Block>
+void append_bases(
+    std::string_view s, DibitVector<Block>& seq,
+    std::vector<std::pair<std::size_t, std::size_t>>& ambiguous) {
+  const auto old_size = seq.size();
+  seq.resize(old_size + s.size());
+  if (pack_ascii(s, seq.begin() + old_size) == 0) return;
+  const auto invalid = [](char c) { return dibit_codes[static_cast<unsigned char>(c)] > 3; };
+  for (auto it = std::find_if(s.begin(), s.end(), invalid); it != s.end();) {
+    const auto last = std::find_if_not(it, s.end(), invalid);
+    const auto first_pos = old_size + static_cast<std::size_t>(it - s.begin());
+    const auto last_pos = old_size + static_cast<std::size_t>(last - s.begin());
+    if (!ambiguous.empty() && ambiguous.back().second == first_pos)
+      ambiguous.back().second = last_pos;
+    else
+      ambiguous.emplace_back(first_pos, last_pos);
+    it = std::find_if(last, s.end(), invalid);
+  }
+}
+
+// Lines of an input read chunk_size bytes at a time, without their "\n" or "\r\n".
+class LineReader {
+  std::function<std::size_t(char*, std::size_t)> read_;
+  std::vector<std::shared_ptr<std::vector<char>>> chunks_;
+  std::size_t cur_ = 0, begin_ = 0, end_ = 0;
+  bool eof_ = false;
+  std::optional<std::string_view> pending_;
+
+ public:
+  LineReader(std::function<std::size_t(char*, std::size_t)> read, std::size_t chunk_size)
+      : read_(std::move(read)),
+        chunks_{std::make_shared<std::vector<char>>(std::max<std::size_t>(chunk_size, 1))} {}
+
+  // The line stays valid until the next call, or for as long as a copy of chunk() is held.
+  bool getline(std::string_view& line) {
+    if (pending_) {
+      line = *std::exchange(pending_, std::nullopt);
+      return true;
+    }
+    for (std::size_t scanned = 0;;) {
+      const char* first = chunks_[cur_]->data() + begin_;
+      if (const void* nl = std::memchr(first + scanned, '\n', end_ - begin_ - scanned)) {
+        const auto n = static_cast<std::size_t>(static_cast<const char*>(nl) - first);
+        begin_ += n + 1;
+        line = std::string_view(first, n - (n != 0 && first[n - 1] == '\r'));
+        return true;
+      }
+      scanned = end_ - begin_;
+      if (eof_) {
+        if (scanned == 0) return false;
+        begin_ = end_;
+        line = std::string_view(first, scanned - (first[scanned - 1] == '\r'));
+        return true;
+      }
+      refill();
+    }
+  }
+
+  // Return the line to be read again by the next getline, nothing else may be read before.
+  void unget(std::string_view line) noexcept { pending_ = line; }
+
+  // The chunk holding the last line.
+  const std::shared_ptr<std::vector<char>>& chunk() const noexcept { return chunks_[cur_]; }
+
+ private:
+  // Move the unread bytes to the front of the chunk, or to a free chunk while copies of this
+  // one are held, then read more.
+  void refill() {
+    const auto unread = end_ - begin_;
+    const auto size = std::max(chunks_[cur_]->size(), unread * 2);
+    if (chunks_[cur_].use_count() == 1) {
+      if (begin_ != 0) std::memmove(chunks_[cur_]->data(), chunks_[cur_]->data() + begin_, unread);
+    } else {
+      const auto free = std::ranges::find_if(chunks_, [](auto& c) { return c.use_count() == 1; });
+      const auto next = static_cast<std::size_t>(free - chunks_.begin());
+      if (free == chunks_.end()) chunks_.push_back(std::make_shared<std::vector<char>>(size));
+      if (chunks_[next]->size() < size) chunks_[next]->resize(size);
+      std::memcpy(chunks_[next]->data(), chunks_[cur_]->data() + begin_, unread);
+      cur_ = next;
+    }
+    auto& buf = *chunks_[cur_];
+    if (unread == buf.size()) buf.resize(buf.size() * 2);
+    begin_ = 0;
+    end_ = unread;
+    const auto n = read_(buf.data() + end_, buf.size() - end_);
+    end_ += n;
+    eof_ = n == 0;
+  }
+};
+
+[[noreturn]] inline void throw_fastx_error(const char* what) {
+  throw std::runtime_error(std::string("FastxReader: ") + what);
+}
+
+// Split the next record into sink.name, sink.bases and sink.qual calls, the last two once per
+// line. Returns false at the end of the input.
+template <typename Sink>
+bool parse_fastx(LineReader& in, Sink& sink) {
+  std::string_view line;
+  do {
+    if (!in.getline(line)) return false;
+  } while (line.empty());
+  if (line[0] != '>' && line[0] != '@') throw_fastx_error("expected a '>' or '@' header");
+  sink.name(line.substr(1));
+  if (line[0] == '>') {
+    while (in.getline(line)) {
+      if (!line.empty() && line[0] == '>') {
+        in.unget(line);
+        break;
+      }
+      if (line.empty() || line[0] == ';') continue;
+      sink.bases(line);
+    }
+    return true;
+  }
+  std::size_t n = 0, q = 0;
+  for (;;) {
+    if (!in.getline(line)) throw_fastx_error("truncated FASTQ record");
+    if (!line.empty() && line[0] == '+') break;
+    sink.bases(line);
+    n += line.size();
+  }
+  while (q < n) {
+    if (!in.getline(line)) throw_fastx_error("truncated FASTQ record");
+    sink.qual(line);
+    q += line.size();
+  }
+  if (q != n) throw_fastx_error("quality and sequence lengths differ");
+  return true;
+}
+
+// A queue whose capacity is bounded by the number of elements in circulation.
+template <typename T>
+class ClosableQueue {
+  std::mutex m_;
+  std::condition_variable cv_;
+  std::deque<T> q_;
+  bool closed_ = false;
+
+ public:
+  void push(T x) {
+    {
+      std::lock_guard l(m_);
+      q_.push_back(std::move(x));
+    }
+    cv_.notify_one();
+  }
+
+  // Wait for an element, nullopt once the queue is closed.
+  std::optional<T> pop() {
+    std::unique_lock l(m_);
+    cv_.wait(l, [&] { return !q_.empty() || closed_; });
+    if (closed_) return std::nullopt;
+    auto x = std::move(q_.front());
+    q_.pop_front();
+    return x;
+  }
+
+  void close() {
+    {
+      std::lock_guard l(m_);
+      closed_ = true;
+    }
+    cv_.notify_all();
+  }
+};
+
+template <std::unsigned_integral Block>
+class FastxReader {
+  // A record split by the reading thread, its bases are packed by the calling thread straight
+  // from the input chunks.
+  struct RawRecord {
+    std::string name;
+    std::vector<std::string_view> bases;
+    std::string qual;
+  };
+
+  // Recycled between the two threads so that their strings keep their capacity. The chunks the
+  // bases point into are held until the batch comes back, and released by the reading thread.
+  struct Batch {
+    std::vector<RawRecord> records;
+    std::vector<std::shared_ptr<std::vector<char>>> chunks;
+    std::size_t size = 0;
+    bool last = false;
+    std::exception_ptr error;
+  };
+
+  struct DirectSink {
+    FastxRecord<Block>& r;
+    void name(std::string_view s) { r.name = s; }
+    void bases(std::string_view s) { append_bases(s, r.seq, r.ambiguous); }
+    void qual(std::string_view s) { r.qual += s; }
+  };
+
+  struct RawSink {
+    RawRecord& r;
+    Batch& b;
+    const LineReader& in;
+    std::size_t bytes = 0;
+    void name(std::string_view s) {
+      r.name = s;
+      bytes += s.size();
+    }
+    void bases(std::string_view s) {
+      if (b.chunks.empty() || b.chunks.back() != in.chunk()) b.chunks.push_back(in.chunk());
+      r.bases.push_back(s);
+      bytes += s.size();
+    }
+    void qual(std::string_view s) {
+      r.qual += s;
+      bytes += s.size();
+    }
+  };
+
+  FastxOptions options_;
+  LineReader in_;
+  ClosableQueue<std::unique_ptr<Batch>> free_, full_;
+  std::unique_ptr<Batch> batch_;
+  std::size_t next_ = 0;
+  bool done_ = false;
+  std::thread thread_;
+
+ public:
+  FastxReader(std::istream& is, FastxOptions options = {})
+      : FastxReader(
+            [&is](char* p, std::size_t n) {
+              is.read(p, static_cast<std::streamsize>(n));
+              return static_cast<std::size_t>(is.gcount());
+            },
+            options) {}
+
+#if __has_include(<unistd.h>)
+  FastxReader(int fd, FastxOptions options = {})
+      : FastxReader(
+            [fd](char* p, std::size_t n) {
+              for (;;) {
+                if (const auto r = ::read(fd, p, n); r >= 0) return static_cast<std::size_t>(r);
+                if (errno != EINTR) throw std::system_error(errno, std::generic_category());
+              }
+            },
+            options) {}
+#endif
+
+  FastxReader(const FastxReader&) = delete;
+
+  FastxReader& operator=(const FastxReader&) = delete;
+
+  ~FastxReader() {
+    free_.close();
+    full_.close();
+    if (thread_.joinable()) thread_.join();
+  }
+
+  // Read the next record into r, reusing its storage. Returns false at the end of the input.
+  bool read(FastxRecord<Block>& r);
+
+ private:
+  FastxReader(std::function<std::size_t(char*, std::size_t)> read, FastxOptions options)
+      : options_(options), in_(std::move(read), options.chunk_size) {
+    if (!options_.pipelined) return;
+    for (std::size_t i = 0; i < std::max<std::size_t>(options_.queue_depth, 1); ++i)
+      free_.push(std::make_unique<Batch>());
+    thread_ = std::thread([this] { produce(); });
+  }
+
+  void produce();
+};
+
+template <std::unsigned_integral Block>
+bool FastxReader<Block>::read(FastxRecord<Block>& r) {
+  r.clear();
+  if (!options_.pipelined) {
+    DirectSink sink{r};
+    return parse_fastx(in_, sink);
+  }
+  while (!batch_ || next_ == batch_->size) {
+    if (batch_) {
+      // The records parsed before an error are handed out first, as in direct mode.
+      if (batch_->error) {
+        done_ = true;
+        std::rethrow_exception(std::exchange(batch_->error, nullptr));
+      }
+      if (batch_->last) done_ = true;
+      free_.push(std::move(batch_));
+    }
+    if (done_) return false;
+    auto batch = full_.pop();
+    if (!batch) return false;
+    batch_ = std::move(*batch);
+    next_ = 0;
+  }
+  // Swapping the strings keeps their capacity circulating between r and the batches.
+  auto& raw = batch_->records[next_++];
+  r.name.swap(raw.name);
+  for (auto line : raw.bases) append_bases(line, r.seq, r.ambiguous);
+  r.qual.swap(raw.qual);
+  return true;
+}
+
+template <std::unsigned_integral Block>
+void FastxReader<Block>::produce() {
+  while (auto batch = free_.pop()) {
+    auto& b = **batch;
+    b.size = 0;
+    b.chunks.clear();
+    try {
+      for (std::size_t bytes = 0; bytes < options_.chunk_size;) {
+        if (b.size == b.records.size()) b.records.emplace_back();
+        auto& raw = b.records[b.size];
+        raw.name.clear();
+        raw.bases.clear();
+        raw.qual.clear();
+        RawSink sink{raw, b, in_};
+        if (!parse_fastx(in_, sink)) {
+          b.last = true;
+          break;
+        }
+        ++b.size;
+        bytes += sink.bytes;
+      }
+    } catch (...) {
+      b.error = std::current_exception();
+      b.last = true;
+    }
+    const bool last = b.last;
+    full_.push(std::move(*batch));
+    if (last) return;
+  }
+}
+
+}  // namespace biomodern::detail
+
+namespace biomodern {
+
+template <std::unsigned_integral Block = std::uint8_t>
+using FastxRecord = detail::FastxRecord<Block>;
+
+template <std::unsigned_integral Block = std::uint8_t>
+using FastxReader = detail::FastxReader<Block>;
+
+using FastxOptions = detail::FastxOptions;
+
+}  // namespace biomodern
@@ -0,0 +1,254 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+
+#if __has_include(<sys/mman.h>)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define XBIT_VECTOR_HAS_MMAP 1
+#endif
+
+#include "xbit_vector.hpp"
+
+namespace biomodern::detail {
+
+// On-disk layout: a 64-byte header followed by the raw blocks, which therefore start 64-byte
+// aligned in a mapping. Every field is in the byte order recorded in the header. The bits of the
+// last block past the last xbit are written as zeros, and the payload is padded with zeros to a
+// multiple of 8 bytes so that the last block can be mapped whatever the block width.
+struct FileHeader {
+  constexpr static std::array<char, 8> file_magic = {'X', 'B', 'I', 'T', 'V', 'E', 'C', '\0'};
+  constexpr static std::uint32_t current_version = 1;
+  constexpr static std::uint8_t little = 0, big = 1;
+
+  std::array<char, 8> magic = file_magic;
+  std::uint32_t version = current_version;
+  std::uint8_t xbits = 0;
+  std::uint8_t block_bytes = 0;
+  std::uint8_t endian = std::endian::native == std::endian::little ? little : big;
+  std::uint8_t reserved = 0;
+  std::uint64_t size = 0;
+  std::uint64_t payload_bytes = 0;
+  std::array<char, 32> padding{};
+
+  // The payload holding the given bytes of blocks, with the padding to a multiple of 8 bytes.
+  constexpr static std::uint64_t padded_payload(std::uint64_t bytes) noexcept {
+    return (bytes + 7) / 8 * 8;
+  }
+};
+
+static_assert(sizeof(FileHeader) == 64);
+
+[[noreturn]] inline void throw_file_error(const std::string& what, const std::filesystem::path& p) {
+  throw std::runtime_error("XbitVector: " + what + ": " + p.string());
+}
+
+// Check that the header describes xbits of width N that can be read as Block on this machine.
+// With little-endian payloads the packed xbits form the same byte stream whatever the block
+// width, otherwise the block width has to match.
+template <std::size_t N, std::unsigned_integral Block>
+void check_header(const FileHeader& h, const std::filesystem::path& p) {
+  constexpr auto native = FileHeader{}.endian;
+  if (h.magic != FileHeader::file_magic) throw_file_error("not an XbitVector file", p);
+  if (h.endian != native) throw_file_error("byte order differs from this machine", p);
+  if (h.version > FileHeader::current_version) throw_file_error("unsupported version", p);
+  if (h.xbits != N) throw_file_error("element width differs", p);
+  if (native != FileHeader::little && h.block_bytes != sizeof(Block))
+    throw_file_error("block width differs", p);
+  if (h.payload_bytes < (h.size * N + CHAR_BIT - 1) / CHAR_BIT)
+    throw_file_error("payload too short", p);
+}
+
+template <std::size_t N, typename Block>
+void save_xbits(XbitSpan<N, const Block> s, const std::filesystem::path& p) {
+  constexpr std::size_t W = block_bits<Block>;
+  if (s.offset() != 0) {
+    // Realign the xbits to the start of a block.
+    XbitVector<N, Block, std::allocator<Block>> v(s.begin(), s.end());
+    save_xbits(XbitSpan<N, const Block>(v), p);
+    return;
+  }
+  const std::size_t full = s.size() * N / W, rest = s.size() * N % W;
+  FileHeader h;
+  h.xbits = N;
+  h.block_bytes = sizeof(Block);
+  h.size = s.size();
+  const std::size_t bytes = (full + (rest != 0)) * sizeof(Block);
+  h.payload_bytes = FileHeader::padded_payload(bytes);
+  std::ofstream out(p, std::ios::binary | std::ios::trunc);
+  if (!out) throw_file_error("cannot open for writing", p);
+  out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  out.write(reinterpret_cast<const char*>(s.data()), full * sizeof(Block));
+  if (rest != 0) {
+    const Block last = s.data()[full] & low_mask<Block>(rest);
+    out.write(reinterpret_cast<const char*>(&last), sizeof(last));
+  }
+  constexpr std::array<char, 8> zeros{};
+  out.write(zeros.data(), static_cast<std::streamsize>(h.payload_bytes - bytes));
+  if (!out.flush()) throw_file_error("write failed", p);
+}
+
+// Read the blocks straight into the storage of v.
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+void load_xbits(const std::filesystem::path& p, XbitVector<N, Block, Allocator, InlineBlocks>& v) {
+  std::ifstream in(p, std::ios::binary);
+  if (!in) throw_file_error("cannot open for reading", p);
+  FileHeader h;
+  if (!in.read(reinterpret_cast<char*>(&h), sizeof(h))) throw_file_error("truncated header", p);
+  check_header<N, Block>(h, p);
+  v.clear();
+  v.resize(h.size);
+  const auto bytes = (h.size * N + CHAR_BIT - 1) / CHAR_BIT;
+  if (!in.read(reinterpret_cast<char*>(v.data()), static_cast<std::streamsize>(bytes)))
+    throw_file_error("truncated payload", p);
+}
+
+#if defined(XBIT_VECTOR_HAS_MMAP)
+// A read-only mapping of a saved XbitVector, unmapped on destruction.
+template <std::size_t N, std::unsigned_integral Block>
+class XbitMapping {
+  void* addr_ = nullptr;
+  std::size_t length_ = 0;
+  XbitSpan<N, const Block> span_;
+
+ public:
+  enum class Advice { normal = MADV_NORMAL, sequential = MADV_SEQUENTIAL, random = MADV_RANDOM };
+
+  typedef XbitSpan<N, const Block> span_type;
+  typedef typename span_type::iterator iterator;
+  typedef typename span_type::size_type size_type;
+
+  XbitMapping() noexcept = default;
+
+  // The pages are requested with MADV_WILLNEED so that they are read ahead in the background,
+  // advice describes the access pattern which follows.
+  explicit XbitMapping(const std::filesystem::path& p, Advice advice = Advice::normal);
+
+  XbitMapping(XbitMapping&& other) noexcept
+      : addr_(std::exchange(other.addr_, nullptr)),
+        length_(std::exchange(other.length_, 0)),
+        span_(std::exchange(other.span_, {})) {}
+
+  XbitMapping& operator=(XbitMapping other) noexcept {
+    std::swap(addr_, other.addr_);
+    std::swap(length_, other.length_);
+    std::swap(span_, other.span_);
+    return *this;
+  }
+
+  ~XbitMapping() {
+    if (addr_ != nullptr) ::munmap(addr_, length_);
+  }
+
+  span_type span() const noexcept { return span_; }
+
+  operator span_type() const noexcept { return span_; }
+
+  iterator begin() const noexcept { return span_.begin(); }
+
+  iterator end() const noexcept { return span_.end(); }
+
+  size_type size() const noexcept { return span_.size(); }
+
+  const Block* data() const noexcept { return span_.data(); }
+};
+
+template <std::size_t N, std::unsigned_integral Block>
+XbitMapping<N, Block>::XbitMapping(const std::filesystem::path& p, Advice advice) {
+  const int fd = ::open(p.c_str(), O_RDONLY);
+  if (fd < 0) throw_file_error("cannot open for reading", p);
+  struct ::stat st {};
+  if (::fstat(fd, &st) != 0 || static_cast<std::size_t>(st.st_size) < sizeof(FileHeader)) {
+    ::close(fd);
+    throw_file_error("truncated header", p);
+  }
+  length_ = static_cast<std::size_t>(st.st_size);
+  addr_ = ::mmap(nullptr, length_, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (addr_ == MAP_FAILED) {
+    addr_ = nullptr;
+    throw_file_error("mmap failed", p);
+  }
+  FileHeader h;
+  std::memcpy(&h, addr_, sizeof(h));
+  try {
+    check_header<N, Block>(h, p);
+    const auto blocks = (h.size * N + block_bits<Block> - 1) / block_bits<Block>;
+    if (length_ - sizeof(h) < h.payload_bytes) throw_file_error("truncated payload", p);
+    // The last block is read as a whole, it may not extend past the payload.
+    if (h.payload_bytes < blocks * sizeof(Block))
+      throw_file_error("payload too short for this block width", p);
+  } catch (...) {
+    ::munmap(addr_, length_);
+    throw;
+  }
+  ::madvise(addr_, length_, static_cast<int>(advice));
+  ::madvise(addr_, length_, MADV_WILLNEED);
+  span_ = span_type(
+      reinterpret_cast<const Block*>(static_cast<const char*>(addr_) + sizeof(h)), h.size);
+}
+#endif
+
+}  // namespace biomodern::detail
+
+namespace biomodern {
+
+// Write the xbits of v to p in the native XbitVector format, see detail::FileHeader.
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+void save(
+    const detail::XbitVector<N, Block, Allocator, InlineBlocks>& v,
+    const std::filesystem::path& p) {
+  detail::save_xbits(detail::XbitSpan<N, const Block>(v), p);
+}
+
+template <std::size_t N, typename Block>
+void save(detail::XbitSpan<N, Block> s, const std::filesystem::path& p) {
+  detail::save_xbits(detail::XbitSpan<N, const std::remove_const_t<Block>>(s), p);
+}
+
+// Replace the content of v by the one saved in p.
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+void load(
+    const std::filesystem::path& p, detail::XbitVector<N, Block, Allocator, InlineBlocks>& v) {
+  detail::load_xbits(p, v);
+}
+
+// Unqualified so that the loaders of other containers, e.g. string sets, are found by ADL.
+template <typename Vector>
+Vector load(const std::filesystem::path& p) {
+  Vector v;
+  load_xbits(p, v);
+  return v;
+}
+
+#if defined(XBIT_VECTOR_HAS_MMAP)
+template <std::unsigned_integral Block = std::uint8_t>
+using DibitMapping = detail::XbitMapping<2, Block>;
+
+template <std::unsigned_integral Block = std::uint8_t>
+using QuadbitMapping = detail::XbitMapping<4, Block>;
+
+// Map a file saved by save, the xbits are read-only and paged in on demand.
+template <typename Mapping>
+Mapping map(
+    const std::filesystem::path& p,
+    typename Mapping::Advice advice = Mapping::Advice::normal) {
+  return Mapping(p, advice);
+}
+#endif
+
+}  // namespace biomodern
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <iterator>
+#include <ranges>
+
+#include "xbit_vector.hpp"
+
+namespace biomodern::detail {
+
+// The k-mers of a range of dibits as 2k-bit integers, the first base in the most significant
+// bits. Every step shifts in the next dibit read from its block, the reverse complement is
+// maintained alongside when Canonical is set and the smaller of the two is yielded.
+template <typename Kmer, std::unsigned_integral Block, bool Canonical>
+class KmerView : public std::ranges::view_interface<KmerView<Kmer, Block, Canonical>> {
+  constexpr static std::size_t xbits_per_block = block_bits<Block> / 2;
+
+  const Block* data_ = nullptr;
+  std::size_t first_ = 0, last_ = 0, k_ = 1;
+
+ public:
+  constexpr static std::size_t max_k = sizeof(Kmer) * CHAR_BIT / 2;
+
+  class iterator {
+    friend class KmerView;
+
+    const Block* data_ = nullptr;
+    // The current k-mer is made of the k bases before next_.
+    std::size_t next_ = 0, last_ = 0, shift_ = 0;
+    Kmer mask_{}, fwd_{}, rev_{};
+
+    constexpr std::uint8_t base(std::size_t i) const noexcept {
+      return static_cast<std::uint8_t>(
+          data_[i / xbits_per_block] >> (i % xbits_per_block * 2) & 3);
+    }
+
+    constexpr void push(std::uint8_t b) noexcept {
+      fwd_ = static_cast<Kmer>((fwd_ << 2 | b) & mask_);
+      if constexpr (Canonical) rev_ = static_cast<Kmer>(rev_ >> 2 | Kmer{3u ^ b} << shift_);
+    }
+
+    constexpr iterator(const KmerView& v) noexcept
+        : data_(v.data_), next_(v.first_), last_(v.last_), shift_(2 * (v.k_ - 1)),
+          mask_(static_cast<Kmer>(~Kmer{} >> (2 * (max_k - v.k_)))) {
+      if (last_ - next_ < v.k_) next_ = last_ + 1;
+      else
+        while (next_ - v.first_ < v.k_) push(base(next_++));
+    }
+
+   public:
+    typedef std::forward_iterator_tag iterator_category;
+    typedef Kmer value_type;
+    typedef std::ptrdiff_t difference_type;
+
+    constexpr iterator() noexcept = default;
+
+    constexpr Kmer operator*() const noexcept {
+      if constexpr (Canonical) return std::min(fwd_, rev_);
+      else
+        return fwd_;
+    }
+
+    constexpr iterator& operator++() noexcept {
+      if (next_ != last_) push(base(next_));
+      ++next_;
+      return *this;
+    }
+
+    constexpr iterator operator++(int) noexcept {
+      iterator tmp = *this;
+      ++*this;
+      return tmp;
+    }
+
+    constexpr bool operator==(const iterator& other) const noexcept {
+      return next_ == other.next_;
+    }
+
+    constexpr bool operator==(std::default_sentinel_t) const noexcept { return next_ > last_; }
+  };
+
+  constexpr KmerView() noexcept = default;
+
+  // The k-mers of the dibits [first, last) of data.
+  constexpr KmerView(
+      const Block* data, std::size_t first, std::size_t last, std::size_t k) noexcept
+      : data_(data), first_(first), last_(last), k_(k) {
+    assert(first <= last && 0 < k && k <= max_k);
+  }
+
+  constexpr iterator begin() const noexcept { return iterator(*this); }
+
+  constexpr std::default_sentinel_t end() const noexcept { return {}; }
+
+  constexpr std::size_t size() const noexcept {
+    return last_ - first_ < k_ ? 0 : last_ - first_ - k_ + 1;
+  }
+
+  constexpr std::size_t k() const noexcept { return k_; }
+};
+
+template <typename Kmer, bool Canonical, std::unsigned_integral Block>
+constexpr auto make_kmer_view(
+    const XbitIteratorBase<2, Block>& first, const XbitIteratorBase<2, Block>& last,
+    std::size_t k) noexcept {
+  return KmerView<Kmer, Block, Canonical>(
+      first.segment(), first.offset(), first.offset() + (last - first), k);
+}
+
+}  // namespace biomodern::detail
+
+namespace std::ranges {
+
+template <typename Kmer, std::unsigned_integral Block, bool Canonical>
+inline constexpr bool enable_borrowed_range<biomodern::detail::KmerView<Kmer, Block, Canonical>> =
+    true;
+
+}  // namespace std::ranges
+
+namespace biomodern {
+
+// The k-mers of v, k <= 32 for the default std::uint64_t and k <= 64 for unsigned __int128.
+template <
+    typename Kmer = std::uint64_t, std::unsigned_integral Block,
+    std::copy_constructible Allocator, std::size_t InlineBlocks>
+constexpr auto kmers(
+    const SmallDibitVector<InlineBlocks, Block, Allocator>& v, std::size_t k) noexcept {
+  return detail::make_kmer_view<Kmer, false>(v.begin(), v.end(), k);
+}
+
+// The smaller of every k-mer of v and its reverse complement.
+template <
+    typename Kmer = std::uint64_t, std::unsigned_integral Block,
+    std::copy_constructible Allocator, std::size_t InlineBlocks>
+constexpr auto canonical_kmers(
+    const SmallDibitVector<InlineBlocks, Block, Allocator>& v, std::size_t k) noexcept {
+  return detail::make_kmer_view<Kmer, true>(v.begin(), v.end(), k);
+}
+
+template <typename Kmer = std::uint64_t, typename Block>
+constexpr auto kmers(detail::XbitSpan<2, Block> s, std::size_t k) noexcept {
+  return detail::make_kmer_view<Kmer, false>(s.begin(), s.end(), k);
+}
+
+template <typename Kmer = std::uint64_t, typename Block>
+constexpr auto canonical_kmers(detail::XbitSpan<2, Block> s, std::size_t k) noexcept {
+  return detail::make_kmer_view<Kmer, true>(s.begin(), s.end(), k);
+}
+
+template <typename Kmer = std::uint64_t, typename I>
+requires std::derived_from<I, typename I::Base>
+constexpr auto kmers(I first, I last, std::size_t k) noexcept {
+  return detail::make_kmer_view<Kmer, false>(first, last, k);
+}
+
+template <typename Kmer = std::uint64_t, typename I>
+requires std::derived_from<I, typename I::Base>
+constexpr auto canonical_kmers(I first, I last, std::size_t k) noexcept {
+  return detail::make_kmer_view<Kmer, true>(first, last, k);
+}
+
+}  // namespace biomodern
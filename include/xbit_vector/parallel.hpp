@@ -0,0 +1,442 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <numeric>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "ascii.hpp"
+
+namespace biomodern::detail {
+
+// A fixed set of threads running one batch of tasks at a time, the calling thread takes part.
+class ThreadPool {
+  std::vector<std::thread> workers_;
+  std::mutex m_;
+  std::condition_variable start_, done_;
+  const std::function<void(std::size_t)>* task_ = nullptr;
+  std::size_t tasks_ = 0, generation_ = 0, busy_ = 0;
+  std::atomic<std::size_t> next_ = 0;
+  std::exception_ptr error_;
+  bool stop_ = false;
+
+ public:
+  // threads counts the calling thread.
+  explicit ThreadPool(std::size_t threads = std::thread::hardware_concurrency()) {
+    for (std::size_t i = 1; i < threads; ++i) workers_.emplace_back([this] { work(); });
+  }
+
+  ThreadPool(const ThreadPool&) = delete;
+
+  ThreadPool& operator=(const ThreadPool&) = delete;
+
+  ~ThreadPool() {
+    {
+      std::lock_guard l(m_);
+      stop_ = true;
+    }
+    start_.notify_all();
+    for (auto& t : workers_) t.join();
+  }
+
+  std::size_t size() const noexcept { return workers_.size() + 1; }
+
+  // Call f(0), ..., f(n - 1) and return once they are all done, rethrowing the first exception.
+  // Batches are not reentrant, f must not run another one on the same pool.
+  void run(std::size_t n, const std::function<void(std::size_t)>& f);
+
+ private:
+  void drain() {
+    for (std::size_t i; (i = next_.fetch_add(1, std::memory_order_relaxed)) < tasks_;) {
+      try {
+        (*task_)(i);
+      } catch (...) {
+        std::lock_guard l(m_);
+        if (!error_) error_ = std::current_exception();
+      }
+    }
+  }
+
+  void work();
+};
+
+inline void ThreadPool::run(std::size_t n, const std::function<void(std::size_t)>& f) {
+  if (n <= 1 || workers_.empty()) {
+    for (std::size_t i = 0; i < n; ++i) f(i);
+    return;
+  }
+  {
+    std::lock_guard l(m_);
+    task_ = &f;
+    tasks_ = n;
+    next_.store(0, std::memory_order_relaxed);
+    busy_ = workers_.size();
+    ++generation_;
+  }
+  start_.notify_all();
+  drain();
+  std::unique_lock l(m_);
+  done_.wait(l, [&] { return busy_ == 0; });
+  task_ = nullptr;
+  if (error_) std::rethrow_exception(std::exchange(error_, nullptr));
+}
+
+inline void ThreadPool::work() {
+  for (std::size_t seen = 0;;) {
+    {
+      std::unique_lock l(m_);
+      start_.wait(l, [&] { return stop_ || generation_ != seen; });
+      if (stop_) return;
+      seen = generation_;
+    }
+    drain();
+    std::lock_guard l(m_);
+    if (--busy_ == 0) done_.notify_one();
+  }
+}
+
+// Units of work of 256 KiB, below which a range is handled by the calling thread alone.
+constexpr std::size_t chunk_bits = std::size_t{1} << 21;
+
+// [0, n) split into at most parts ranges at the multiples of a multiple of grain, shifted by
+// -off. With off the offset of an xbit in its block and grain a multiple of the xbits per block,
+// the ranges start on block boundaries and no two of them write to the same block.
+class Chunks {
+  std::size_t off_ = 0, n_ = 0, step_ = 1, size_ = 0;
+
+ public:
+  Chunks(std::size_t off, std::size_t n, std::size_t grain, std::size_t parts) noexcept
+      : off_(off), n_(n) {
+    if (n == 0) return;
+    const std::size_t grains = (off + n + grain - 1) / grain;
+    step_ = (grains + parts - 1) / parts * grain;
+    size_ = (off + n + step_ - 1) / step_;
+  }
+
+  std::size_t size() const noexcept { return size_; }
+
+  std::pair<std::size_t, std::size_t> operator[](std::size_t t) const noexcept {
+    return {std::max(t * step_, off_) - off_, std::min((t + 1) * step_, off_ + n_) - off_};
+  }
+};
+
+// Xbits straddling blocks would have their blocks written by two threads, so only widths which
+// tile the blocks are split.
+template <std::size_t N, typename Block>
+requires tiled_xbits<N, std::remove_const_t<Block>>
+Chunks make_chunks(ThreadPool& pool, XbitSpan<N, Block> s) noexcept {
+  return Chunks(s.offset(), s.size(), chunk_bits / N, pool.size());
+}
+
+template <std::size_t N, typename Block>
+void parallel_flip(ThreadPool& pool, XbitSpan<N, Block> s) {
+  const auto c = make_chunks(pool, s);
+  pool.run(c.size(), [&](std::size_t t) {
+    const auto [b, e] = c[t];
+    s.subspan(b, e - b).flip();
+  });
+}
+
+template <std::size_t N, typename Block>
+void parallel_fill(ThreadPool& pool, XbitSpan<N, Block> s, xbit_t<N> x) {
+  const auto c = make_chunks(pool, s);
+  pool.run(c.size(), [&](std::size_t t) {
+    const auto [b, e] = c[t];
+    fill_n(s.begin() + b, e - b, x);
+  });
+}
+
+template <std::size_t N, typename Block>
+std::size_t parallel_count(ThreadPool& pool, XbitSpan<N, Block> s, xbit_t<N> x) {
+  const auto c = make_chunks(pool, s);
+  std::vector<std::size_t> partial(c.size());
+  pool.run(c.size(), [&](std::size_t t) {
+    const auto [b, e] = c[t];
+    partial[t] = s.subspan(b, e - b).count(x);
+  });
+  return std::reduce(partial.begin(), partial.end());
+}
+
+template <std::size_t N, typename Block>
+std::array<std::size_t, (1 << N)> parallel_histogram(ThreadPool& pool, XbitSpan<N, Block> s) {
+  const auto c = make_chunks(pool, s);
+  std::vector<std::array<std::size_t, (1 << N)>> partial(c.size());
+  pool.run(c.size(), [&](std::size_t t) {
+    const auto [b, e] = c[t];
+    partial[t] = s.subspan(b, e - b).histogram();
+  });
+  std::array<std::size_t, (1 << N)> h{};
+  for (const auto& p : partial)
+    for (std::size_t x = 0; x < h.size(); ++x) h[x] += p[x];
+  return h;
+}
+
+template <std::size_t N, typename Block>
+bool parallel_equal(ThreadPool& pool, XbitSpan<N, const Block> a, XbitSpan<N, const Block> b) {
+  if (a.size() != b.size()) return false;
+  const auto c = make_chunks(pool, a);
+  std::atomic<bool> differ = false;
+  pool.run(c.size(), [&](std::size_t t) {
+    const auto [first, last] = c[t];
+    if (!differ.load(std::memory_order_relaxed) &&
+        mismatch_length(a.begin() + first, last - first, b.begin() + first) != last - first)
+      differ.store(true, std::memory_order_relaxed);
+  });
+  return !differ;
+}
+
+// Encode s into the first s.size() xbits of v, returns the number of invalid characters.
+template <std::size_t N, typename Block>
+std::size_t parallel_pack_ascii(ThreadPool& pool, std::string_view s, XbitSpan<N, Block> v) {
+  const auto c = make_chunks(pool, v.first(s.size()));
+  std::vector<std::size_t> invalid(c.size());
+  pool.run(c.size(), [&](std::size_t t) {
+    const auto [b, e] = c[t];
+    invalid[t] = pack_ascii(s.substr(b, e - b), v.begin() + b);
+  });
+  return std::reduce(invalid.begin(), invalid.end());
+}
+
+template <std::size_t N, typename Block>
+char* parallel_unpack_ascii(ThreadPool& pool, XbitSpan<N, Block> v, char* out) {
+  const auto c = make_chunks(pool, v);
+  pool.run(c.size(), [&](std::size_t t) {
+    const auto [b, e] = c[t];
+    unpack_ascii(v.cbegin() + b, v.cbegin() + e, out + b);
+  });
+  return out + v.size();
+}
+
+// reverse_complement_bytes on pairs of ranges mirrored around the middle, swapped through a
+// buffer of the task.
+inline void reverse_complement_bytes(ThreadPool& pool, std::uint8_t* first, std::uint8_t* last) {
+  const auto n = static_cast<std::size_t>(last - first), half = n / 2;
+  const Chunks c(0, half, chunk_bits / CHAR_BIT, pool.size());
+  if (c.size() <= 1) {
+    reverse_complement_bytes(first, last);
+    return;
+  }
+  pool.run(c.size(), [&](std::size_t t) {
+    const auto [b, e] = c[t];
+    std::array<std::uint8_t, 4096> buf;
+    for (auto i = b; i < e; i += buf.size()) {
+      const auto k = std::min(buf.size(), e - i);
+      std::uint8_t* const front = first + i;
+      std::uint8_t* const back = last - i - k;
+      std::copy_n(front, k, buf.data());
+      reverse_complement_bytes(back, back + k, front);
+      reverse_complement_bytes(buf.data(), buf.data() + k, back);
+    }
+  });
+  if (n % 2 != 0) first[half] = reverse_complement_byte(first[half]);
+}
+
+// Same steps as the sequential reverse_complement: the covering blocks are reversed, then the
+// dibits are shifted back by delta < xbits_per_block. Each task shifts its own range, the delta
+// dibits it needs from its neighbour are saved beforehand.
+template <std::unsigned_integral Block>
+void parallel_reverse_complement(ThreadPool& pool, XbitSpan<2, Block> s) {
+  constexpr std::size_t xbits_per_block = XbitSpan<2, Block>::xbits_per_block;
+  const auto c = make_chunks(pool, s);
+  if (std::endian::native != std::endian::little || c.size() <= 1) {
+    s.reverse_complement();
+    return;
+  }
+  const std::size_t n = s.size(), head = s.offset();
+  Block* const seg = s.data();
+  Block* const seg_end = s.end().segment() + (s.end().offset() != 0);
+  const std::size_t tail = static_cast<std::size_t>(seg_end - seg) * xbits_per_block - head - n;
+  const Block front = *seg;
+  const Block back = seg_end[-1];
+  reverse_complement_bytes(
+      pool, reinterpret_cast<std::uint8_t*>(seg), reinterpret_cast<std::uint8_t*>(seg_end));
+  if (head != tail) {
+    // Dibit i is moved from i + tail - head, the positions are counted in bits from seg.
+    const std::size_t d = head < tail ? tail - head : head - tail;
+    const auto bit = [&](std::size_t i) { return (head + i) * 2; };
+    std::vector<std::uint64_t> saved(c.size());
+    for (std::size_t t = 0; t < c.size(); ++t) {
+      const auto [b, e] = c[t];
+      const auto k = std::min(e - b, d);
+      saved[t] = head < tail ? load_bits64(seg, bit(e - k + d), k * 2)
+                             : load_bits64(seg, bit(b) - d * 2, k * 2);
+    }
+    pool.run(c.size(), [&](std::size_t t) {
+      const auto [b, e] = c[t];
+      const auto k = std::min(e - b, d);
+      if (head < tail) {
+        if (e - b > d) copy(s.begin() + b + d, s.begin() + e, s.begin() + b);
+        store_bits64(seg, bit(e - k), k * 2, saved[t]);
+      } else {
+        if (e - b > d) copy_backward(s.begin() + b, s.begin() + e - d, s.begin() + e);
+        store_bits64(seg, bit(b), k * 2, saved[t]);
+      }
+    });
+  }
+  if (head != 0) {
+    const Block m = low_mask<Block>(head * 2);
+    *seg = static_cast<Block>((*seg & ~m) | (front & m));
+  }
+  if (tail != 0) {
+    const Block m = static_cast<Block>(~low_mask<Block>((xbits_per_block - tail) * 2));
+    seg_end[-1] = static_cast<Block>((seg_end[-1] & ~m) | (back & m));
+  }
+}
+
+}  // namespace biomodern::detail
+
+namespace biomodern {
+
+using ThreadPool = detail::ThreadPool;
+
+// The bulk operations below split their range on 256 KiB boundaries of the blocks among the
+// threads of the pool, so that no two threads write to the same block. Ranges shorter than that
+// are handled by the calling thread alone.
+
+template <std::size_t N, typename Block>
+requires(!std::is_const_v<Block>) void flip(ThreadPool& pool, detail::XbitSpan<N, Block> s) {
+  detail::parallel_flip(pool, s);
+}
+
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+void flip(ThreadPool& pool, detail::XbitVector<N, Block, Allocator, InlineBlocks>& v) {
+  detail::parallel_flip(pool, detail::XbitSpan<N, Block>(v));
+}
+
+template <std::size_t N, typename Block>
+requires(!std::is_const_v<Block>) void fill(
+    ThreadPool& pool, detail::XbitSpan<N, Block> s, detail::xbit_t<N> x) {
+  detail::parallel_fill(pool, s, x);
+}
+
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+void fill(
+    ThreadPool& pool, detail::XbitVector<N, Block, Allocator, InlineBlocks>& v,
+    detail::xbit_t<N> x) {
+  detail::parallel_fill(pool, detail::XbitSpan<N, Block>(v), x);
+}
+
+template <std::size_t N, typename Block>
+std::size_t count(ThreadPool& pool, detail::XbitSpan<N, Block> s, detail::xbit_t<N> x) {
+  return detail::parallel_count(pool, s, x);
+}
+
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+std::size_t count(
+    ThreadPool& pool, const detail::XbitVector<N, Block, Allocator, InlineBlocks>& v,
+    detail::xbit_t<N> x) {
+  return detail::parallel_count(pool, detail::XbitSpan<N, const Block>(v), x);
+}
+
+template <std::size_t N, typename Block>
+std::array<std::size_t, (1 << N)> histogram(ThreadPool& pool, detail::XbitSpan<N, Block> s) {
+  return detail::parallel_histogram(pool, s);
+}
+
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+std::array<std::size_t, (1 << N)> histogram(
+    ThreadPool& pool, const detail::XbitVector<N, Block, Allocator, InlineBlocks>& v) {
+  return detail::parallel_histogram(pool, detail::XbitSpan<N, const Block>(v));
+}
+
+template <std::size_t N, typename Block1, typename Block2>
+requires std::same_as<std::remove_const_t<Block1>, std::remove_const_t<Block2>>
+bool equal(ThreadPool& pool, detail::XbitSpan<N, Block1> a, detail::XbitSpan<N, Block2> b) {
+  typedef detail::XbitSpan<N, const std::remove_const_t<Block1>> Span;
+  return detail::parallel_equal(pool, Span(a), Span(b));
+}
+
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+bool equal(
+    ThreadPool& pool, const detail::XbitVector<N, Block, Allocator, InlineBlocks>& a,
+    const detail::XbitVector<N, Block, Allocator, InlineBlocks>& b) {
+  typedef detail::XbitSpan<N, const Block> Span;
+  return detail::parallel_equal(pool, Span(a), Span(b));
+}
+
+template <typename Block>
+requires(!std::is_const_v<Block>) void reverse_complement(ThreadPool& pool, DibitSpan<Block> s) {
+  detail::parallel_reverse_complement(pool, s);
+}
+
+template <std::unsigned_integral Block, std::copy_constructible Allocator, std::size_t InlineBlocks>
+void reverse_complement(
+    ThreadPool& pool, detail::XbitVector<2, Block, Allocator, InlineBlocks>& v) {
+  detail::parallel_reverse_complement(pool, DibitSpan<Block>(v));
+}
+
+// The ascii.hpp codecs, with the same append (vectors) and overwrite (spans) semantics.
+template <std::unsigned_integral Block, std::copy_constructible Allocator, std::size_t InlineBlocks>
+std::size_t pack_ascii(
+    ThreadPool& pool, std::string_view s,
+    detail::XbitVector<2, Block, Allocator, InlineBlocks>& v) {
+  const auto old_size = v.size();
+  v.resize(old_size + s.size());
+  return detail::parallel_pack_ascii(pool, s, DibitSpan<Block>(v).subspan(old_size));
+}
+
+template <typename Block>
+requires(!std::is_const_v<Block>) std::size_t pack_ascii(
+    ThreadPool& pool, std::string_view s, DibitSpan<Block> v) {
+  assert(s.size() <= v.size());
+  return detail::parallel_pack_ascii(pool, s, v);
+}
+
+template <std::unsigned_integral Block, std::copy_constructible Allocator, std::size_t InlineBlocks>
+char* unpack_ascii(
+    ThreadPool& pool, const detail::XbitVector<2, Block, Allocator, InlineBlocks>& v,
+    char* out) {
+  return detail::parallel_unpack_ascii(pool, DibitSpan<const Block>(v), out);
+}
+
+template <typename Block>
+char* unpack_ascii(ThreadPool& pool, DibitSpan<Block> v, char* out) {
+  return detail::parallel_unpack_ascii(pool, v, out);
+}
+
+template <std::unsigned_integral Block, std::copy_constructible Allocator, std::size_t InlineBlocks>
+std::size_t pack_iupac(
+    ThreadPool& pool, std::string_view s,
+    detail::XbitVector<4, Block, Allocator, InlineBlocks>& v) {
+  const auto old_size = v.size();
+  v.resize(old_size + s.size());
+  return detail::parallel_pack_ascii(pool, s, QuadbitSpan<Block>(v).subspan(old_size));
+}
+
+template <typename Block>
+requires(!std::is_const_v<Block>) std::size_t pack_iupac(
+    ThreadPool& pool, std::string_view s, QuadbitSpan<Block> v) {
+  assert(s.size() <= v.size());
+  return detail::parallel_pack_ascii(pool, s, v);
+}
+
+template <std::unsigned_integral Block, std::copy_constructible Allocator, std::size_t InlineBlocks>
+char* unpack_iupac(
+    ThreadPool& pool, const detail::XbitVector<4, Block, Allocator, InlineBlocks>& v,
+    char* out) {
+  return detail::parallel_unpack_ascii(pool, QuadbitSpan<const Block>(v), out);
+}
+
+template <typename Block>
+char* unpack_iupac(ThreadPool& pool, QuadbitSpan<Block> v, char* out) {
+  return detail::parallel_unpack_ascii(pool, v, out);
+}
+
+}  // namespace biomodern
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <vector>
+
+#include "xbit_vector.hpp"
+
+namespace biomodern::detail {
+
+// Occurrence counts over the blocks of a packed sequence for constant time rank and logarithmic
+// time select. The sequence is split into superblocks whose absolute counts are uint64, each
+// made of blocks whose counts relative to the superblock are uint16. The counters of a
+// superblock are interleaved in one cache-line aligned record, so a rank reads a single record
+// and popcounts at most one block (512 bits for dibits, 2048 bits for quadbits) of the payload.
+// The index only refers to the payload, which must outlive it and not be modified, so it can be
+// built over a span of mapped or shared memory as well, but not over a temporary vector.
+template <std::size_t N, std::unsigned_integral Block>
+class XbitRankIndex {
+ public:
+  typedef Block block_type;
+  typedef std::uint8_t value_type;
+  typedef std::size_t size_type;
+
+  constexpr static size_type sigma = size_type{1} << N;
+  constexpr static size_type block_size = N == 2 ? 256 : 512;
+  constexpr static size_type blocks_per_superblock = N == 2 ? 4 : 8;
+  constexpr static size_type superblock_size = block_size * blocks_per_superblock;
+
+ private:
+  static_assert(block_size * N % block_bits<Block> == 0);
+
+  // 64 bytes per 256 bytes of dibits (25%), 384 bytes per 2048 bytes of quadbits (18.75%).
+  struct alignas(64) Superblock {
+    std::array<std::uint64_t, sigma> base;
+    std::array<std::array<std::uint16_t, sigma>, blocks_per_superblock - 1> rel;
+  };
+
+  const Block* data_ = nullptr;
+  size_type size_ = 0;
+  // The full superblocks, the partial (maybe empty) one, and an empty one holding the totals.
+  std::vector<Superblock> superblocks_;
+
+ public:
+  constexpr XbitRankIndex() noexcept = default;
+
+  constexpr XbitRankIndex(const Block* data, size_type size);
+
+  template <std::copy_constructible Allocator, std::size_t InlineBlocks>
+  constexpr explicit XbitRankIndex(const XbitVector<N, Block, Allocator, InlineBlocks>& v)
+      : XbitRankIndex(v.data(), v.size()) {}
+
+  template <std::copy_constructible Allocator, std::size_t InlineBlocks>
+  XbitRankIndex(XbitVector<N, Block, Allocator, InlineBlocks>&&) = delete;
+
+  // The span must start at the beginning of a block.
+  constexpr explicit XbitRankIndex(XbitSpan<N, const Block> s) : XbitRankIndex(s.data(), s.size()) {
+    assert(s.offset() == 0);
+  }
+
+  constexpr const Block* data() const noexcept { return data_; }
+
+  constexpr size_type size() const noexcept { return size_; }
+
+  // Size of the counters in bytes.
+  constexpr size_type index_bytes() const noexcept {
+    return superblocks_.size() * sizeof(Superblock);
+  }
+
+  // Number of c in [0, size()).
+  constexpr size_type count(value_type c) const noexcept {
+    return superblocks_.empty() ? 0 : superblocks_.back().base[c];
+  }
+
+  // Number of c in [0, i), i <= size().
+  constexpr size_type rank(value_type c, size_type i) const noexcept;
+
+  // Position of the k-th (from 0) c, size() if there are not that many.
+  constexpr size_type select(value_type c, size_type k) const noexcept;
+
+ private:
+  constexpr const Block* block_begin(size_type i) const noexcept {
+    return data_ + i * N / block_bits<Block>;
+  }
+};
+
+template <std::size_t N, std::unsigned_integral Block>
+constexpr XbitRankIndex<N, Block>::XbitRankIndex(const Block* data, size_type size)
+    : data_(data), size_(size), superblocks_(size / superblock_size + 2) {
+  std::array<std::uint64_t, sigma> total{};
+  for (size_type s = 0, i = 0; s < superblocks_.size(); ++s) {
+    auto& sb = superblocks_[s];
+    sb.base = total;
+    std::array<std::uint16_t, sigma> rel{};
+    for (size_type b = 0; b < blocks_per_superblock; ++b) {
+      if (b != 0) sb.rel[b - 1] = rel;
+      const auto n = std::min(block_size, size - i);
+      const auto h = histogram_bits<N>(block_begin(i), 0, n * N);
+      for (size_type c = 0; c < sigma; ++c) rel[c] = static_cast<std::uint16_t>(rel[c] + h[c]);
+      i += n;
+    }
+    for (size_type c = 0; c < sigma; ++c) total[c] += rel[c];
+  }
+}
+
+template <std::size_t N, std::unsigned_integral Block>
+constexpr typename XbitRankIndex<N, Block>::size_type XbitRankIndex<N, Block>::rank(
+    value_type c, size_type i) const noexcept {
+  assert(c < sigma && i <= size_);
+  const auto& sb = superblocks_[i / superblock_size];
+  const auto b = i % superblock_size / block_size;
+  const auto first = i - i % block_size;
+  return sb.base[c] + (b != 0 ? sb.rel[b - 1][c] : 0) +
+         count_bits<N>(block_begin(first), 0, (i - first) * N, c);
+}
+
+template <std::size_t N, std::unsigned_integral Block>
+constexpr typename XbitRankIndex<N, Block>::size_type XbitRankIndex<N, Block>::select(
+    value_type c, size_type k) const noexcept {
+  assert(c < sigma);
+  if (k >= count(c)) return size_;
+  const auto it = std::partition_point(
+      superblocks_.begin(), superblocks_.end(), [=](const auto& sb) { return sb.base[c] <= k; });
+  const auto& sb = *std::prev(it);
+  k -= sb.base[c];
+  size_type b = 0;
+  while (b + 1 < blocks_per_superblock && sb.rel[b][c] <= k) ++b;
+  if (b != 0) k -= sb.rel[b - 1][c];
+  const auto first = static_cast<size_type>(it - superblocks_.begin() - 1) * superblock_size +
+                     b * block_size;
+  const auto pattern = replicate<N, std::uint64_t>(c);
+  for (auto pos = first * N;; pos += 64) {
+    const auto n = std::min<size_type>(64, size_ * N - pos);
+    auto w = zero_lanes<N>(load_bits64(data_, pos, n) ^ pattern) & low_mask<std::uint64_t>(n);
+    if (const auto m = static_cast<size_type>(std::popcount(w)); k >= m) k -= m;
+    else {
+      for (; k != 0; --k) w &= w - 1;
+      return (pos + std::countr_zero(w)) / N;
+    }
+  }
+}
+
+}  // namespace biomodern::detail
+
+namespace biomodern {
+
+template <std::unsigned_integral Block = std::uint8_t>
+using DibitRankIndex = detail::XbitRankIndex<2, Block>;
+
+template <std::unsigned_integral Block = std::uint8_t>
+using QuadbitRankIndex = detail::XbitRankIndex<4, Block>;
+
+}  // namespace biomodern
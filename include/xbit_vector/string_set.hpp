@@ -0,0 +1,421 @@
+#pragma once
+
+#include <cassert>
+#include <compare>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <vector>
+
+#include "io.hpp"
+#include "xbit_vector.hpp"
+
+namespace biomodern::detail {
+
+// Random access iterator over the sequences of an XbitStringSet, which dereferences to spans.
+template <std::size_t N, typename Block>
+class XbitStringSetIterator {
+  template <std::size_t, typename>
+  friend class XbitStringSetIterator;
+
+ public:
+  typedef std::random_access_iterator_tag iterator_category;
+  typedef XbitSpan<N, Block> value_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef value_type reference;
+  typedef void pointer;
+
+ private:
+  typename value_type::iterator symbols_{};
+  const std::uint64_t* offset_ = nullptr;
+
+ public:
+  constexpr XbitStringSetIterator() noexcept = default;
+
+  constexpr XbitStringSetIterator(
+      typename value_type::iterator symbols, const std::uint64_t* offset) noexcept
+      : symbols_(symbols), offset_(offset) {}
+
+  template <typename B>
+  requires(std::is_const_v<Block> && std::same_as<B, std::remove_const_t<Block>>)
+  constexpr XbitStringSetIterator(const XbitStringSetIterator<N, B>& it) noexcept
+      : symbols_(it.symbols_), offset_(it.offset_) {}
+
+  constexpr reference operator*() const noexcept {
+    return value_type(
+        symbols_ + static_cast<difference_type>(offset_[0]),
+        static_cast<std::size_t>(offset_[1] - offset_[0]));
+  }
+
+  constexpr reference operator[](difference_type n) const noexcept { return *(*this + n); }
+
+  constexpr XbitStringSetIterator& operator++() noexcept {
+    ++offset_;
+    return *this;
+  }
+
+  constexpr XbitStringSetIterator operator++(int) noexcept {
+    XbitStringSetIterator tmp = *this;
+    ++offset_;
+    return tmp;
+  }
+
+  constexpr XbitStringSetIterator& operator--() noexcept {
+    --offset_;
+    return *this;
+  }
+
+  constexpr XbitStringSetIterator operator--(int) noexcept {
+    XbitStringSetIterator tmp = *this;
+    --offset_;
+    return tmp;
+  }
+
+  constexpr XbitStringSetIterator& operator+=(difference_type n) noexcept {
+    offset_ += n;
+    return *this;
+  }
+
+  constexpr XbitStringSetIterator& operator-=(difference_type n) noexcept {
+    offset_ -= n;
+    return *this;
+  }
+
+  constexpr XbitStringSetIterator operator+(difference_type n) const noexcept {
+    XbitStringSetIterator tmp = *this;
+    return tmp += n;
+  }
+
+  friend constexpr XbitStringSetIterator operator+(
+      difference_type n, const XbitStringSetIterator& it) noexcept {
+    return it + n;
+  }
+
+  constexpr XbitStringSetIterator operator-(difference_type n) const noexcept {
+    XbitStringSetIterator tmp = *this;
+    return tmp -= n;
+  }
+
+  constexpr difference_type operator-(const XbitStringSetIterator& other) const noexcept {
+    return offset_ - other.offset_;
+  }
+
+  constexpr bool operator==(const XbitStringSetIterator& other) const noexcept {
+    return offset_ == other.offset_;
+  }
+
+  constexpr std::strong_ordering operator<=>(const XbitStringSetIterator& other) const noexcept {
+    return offset_ <=> other.offset_;
+  }
+};
+
+// A collection of xbit sequences concatenated in one XbitVector, with the start of every
+// sequence and the end of the last in an offsets array. A sequence costs 8 bytes of offset and
+// no allocation, and the set is laid out contiguously for scans and for saving.
+template <
+    std::size_t N, std::unsigned_integral Block = std::uint8_t,
+    std::copy_constructible Allocator = std::allocator<Block>>
+class XbitStringSet {
+ public:
+  typedef XbitVector<N, Block, Allocator> vector_type;
+  typedef typename vector_type::value_type symbol_type;
+  typedef Block block_type;
+  typedef Allocator allocator_type;
+  typedef XbitSpan<N, Block> value_type;
+  typedef value_type reference;
+  typedef XbitSpan<N, const Block> const_reference;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef XbitStringSetIterator<N, Block> iterator;
+  typedef XbitStringSetIterator<N, const Block> const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+ private:
+  typedef typename std::allocator_traits<Allocator>::template rebind_alloc<std::uint64_t>
+      offset_allocator;
+
+  vector_type symbols_;
+  std::vector<std::uint64_t, offset_allocator> offsets_;
+
+ public:
+  constexpr XbitStringSet() : XbitStringSet(Allocator()) {}
+
+  constexpr explicit XbitStringSet(const Allocator& a)
+      : symbols_(a), offsets_(1, 0, offset_allocator(a)) {}
+
+  constexpr allocator_type get_allocator() const noexcept { return symbols_.get_allocator(); }
+
+  constexpr iterator begin() noexcept { return iterator(symbols_.begin(), offsets_.data()); }
+
+  constexpr const_iterator begin() const noexcept {
+    return const_iterator(symbols_.begin(), offsets_.data());
+  }
+
+  constexpr iterator end() noexcept { return begin() + static_cast<difference_type>(size()); }
+
+  constexpr const_iterator end() const noexcept {
+    return begin() + static_cast<difference_type>(size());
+  }
+
+  constexpr const_iterator cbegin() const noexcept { return begin(); }
+
+  constexpr const_iterator cend() const noexcept { return end(); }
+
+  constexpr reverse_iterator rbegin() noexcept { return reverse_iterator(end()); }
+
+  constexpr const_reverse_iterator rbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+
+  constexpr reverse_iterator rend() noexcept { return reverse_iterator(begin()); }
+
+  constexpr const_reverse_iterator rend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+
+  // Number of sequences.
+  constexpr size_type size() const noexcept { return offsets_.size() - 1; }
+
+  [[nodiscard]] constexpr bool empty() const noexcept { return size() == 0; }
+
+  // Number of symbols of all the sequences.
+  constexpr size_type total_size() const noexcept { return symbols_.size(); }
+
+  // Make room for n_seqs sequences of n_symbols symbols in total.
+  constexpr void reserve(size_type n_seqs, size_type n_symbols) {
+    offsets_.reserve(n_seqs + 1);
+    symbols_.reserve(n_symbols);
+  }
+
+  constexpr void shrink_to_fit() {
+    offsets_.shrink_to_fit();
+    symbols_.shrink_to_fit();
+  }
+
+  // The sequences are views into the shared buffer, their symbols can be modified but not their
+  // lengths. They are invalidated by any change of the set which may reallocate.
+  constexpr reference operator[](size_type i) noexcept { return begin()[i]; }
+
+  constexpr const_reference operator[](size_type i) const noexcept { return begin()[i]; }
+
+  constexpr reference front() noexcept { return (*this)[0]; }
+
+  constexpr const_reference front() const noexcept { return (*this)[0]; }
+
+  constexpr reference back() noexcept { return (*this)[size() - 1]; }
+
+  constexpr const_reference back() const noexcept { return (*this)[size() - 1]; }
+
+  // All the sequences one after the other.
+  constexpr XbitSpan<N, const Block> symbols() const noexcept { return symbols_; }
+
+  // Start of every sequence in symbols(), then total_size().
+  constexpr std::span<const std::uint64_t> offsets() const noexcept { return offsets_; }
+
+  // Append the symbols of r as a new sequence. Vectors and spans are shifted in a block at a
+  // time, r may be one of the sequences of the set.
+  template <std::ranges::input_range R>
+  requires std::convertible_to<std::ranges::range_value_t<R>, symbol_type>
+  constexpr void push_back(R&& r) {
+    const auto old_size = symbols_.size();
+    if constexpr (
+        std::ranges::sized_range<R> &&
+        std::convertible_to<std::ranges::iterator_t<R>, XbitConstIterator<N, Block>>)
+      symbols_.append(XbitSpan<N, const Block>(
+          XbitConstIterator<N, Block>(std::ranges::begin(r)), std::ranges::size(r)));
+    else if constexpr (std::ranges::common_range<R>)
+      symbols_.insert(symbols_.end(), std::ranges::begin(r), std::ranges::end(r));
+    else
+      for (auto&& x : r) symbols_.push_back(static_cast<symbol_type>(x));
+    commit(old_size);
+  }
+
+  // Append a new sequence of n zero symbols and return it, e.g. to pack text in place.
+  constexpr reference emplace_back(size_type n) {
+    const auto old_size = symbols_.size();
+    symbols_.resize(old_size + n);
+    commit(old_size);
+    return back();
+  }
+
+  constexpr void pop_back() noexcept {
+    assert(!empty());
+    offsets_.pop_back();
+    symbols_.resize(offsets_.back());
+  }
+
+  constexpr void clear() noexcept {
+    offsets_.resize(1);
+    symbols_.clear();
+  }
+
+  constexpr void swap(XbitStringSet& other) noexcept {
+    symbols_.swap(other.symbols_);
+    offsets_.swap(other.offsets_);
+  }
+
+  friend constexpr void swap(XbitStringSet& a, XbitStringSet& b) noexcept { a.swap(b); }
+
+  constexpr bool operator==(const XbitStringSet& other) const noexcept {
+    return offsets_ == other.offsets_ && symbols_ == other.symbols_;
+  }
+
+  template <std::size_t M, std::unsigned_integral B, std::copy_constructible A>
+  friend void read_string_set(
+      std::istream& in, XbitStringSet<M, B, A>& s, const std::filesystem::path& p);
+
+ private:
+  // Record the end of the sequence appended after old_size, or drop it if that fails.
+  constexpr void commit(size_type old_size) {
+    try {
+      offsets_.push_back(symbols_.size());
+    } catch (...) {
+      symbols_.resize(old_size);
+      throw;
+    }
+  }
+};
+
+// On-disk layout: a 64-byte header, the size() + 1 offsets as uint64 padded with zeros to a
+// multiple of 64 bytes, then the blocks of the symbols padded as in a saved XbitVector, see
+// FileHeader. Fields are in the byte order recorded in the header.
+struct StringSetHeader {
+  constexpr static std::array<char, 8> file_magic = {'X', 'B', 'I', 'T', 'S', 'E', 'T', '\0'};
+  constexpr static std::uint32_t current_version = 1;
+
+  std::array<char, 8> magic = file_magic;
+  std::uint32_t version = current_version;
+  std::uint8_t xbits = 0;
+  std::uint8_t block_bytes = 0;
+  std::uint8_t endian = FileHeader{}.endian;
+  std::uint8_t reserved = 0;
+  std::uint64_t sequences = 0;
+  std::uint64_t size = 0;
+  std::uint64_t payload_bytes = 0;
+  std::array<char, 24> padding{};
+
+  constexpr std::uint64_t offsets_bytes() const noexcept {
+    return ((sequences + 1) * sizeof(std::uint64_t) + 63) / 64 * 64;
+  }
+};
+
+static_assert(sizeof(StringSetHeader) == 64);
+
+template <std::size_t N, std::unsigned_integral Block>
+void check_header(const StringSetHeader& h, const std::filesystem::path& p) {
+  constexpr auto native = FileHeader{}.endian;
+  if (h.magic != StringSetHeader::file_magic) throw_file_error("not an XbitStringSet file", p);
+  if (h.endian != native) throw_file_error("byte order differs from this machine", p);
+  if (h.version > StringSetHeader::current_version) throw_file_error("unsupported version", p);
+  if (h.xbits != N) throw_file_error("element width differs", p);
+  if (native != FileHeader::little && h.block_bytes != sizeof(Block))
+    throw_file_error("block width differs", p);
+  if (h.payload_bytes < (h.size * N + CHAR_BIT - 1) / CHAR_BIT)
+    throw_file_error("payload too short", p);
+}
+
+template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
+void write_string_set(const XbitStringSet<N, Block, Allocator>& s, std::ostream& out) {
+  constexpr std::size_t W = block_bits<Block>;
+  const auto symbols = s.symbols();
+  const auto offsets = s.offsets();
+  const std::size_t full = symbols.size() * N / W, rest = symbols.size() * N % W;
+  StringSetHeader h;
+  h.xbits = N;
+  h.block_bytes = sizeof(Block);
+  h.sequences = s.size();
+  h.size = symbols.size();
+  const std::size_t bytes = (full + (rest != 0)) * sizeof(Block);
+  h.payload_bytes = FileHeader::padded_payload(bytes);
+  const std::array<char, 64> zeros{};
+  out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+  out.write(reinterpret_cast<const char*>(offsets.data()), std::streamsize(offsets.size_bytes()));
+  out.write(zeros.data(), std::streamsize(h.offsets_bytes() - offsets.size_bytes()));
+  out.write(reinterpret_cast<const char*>(symbols.data()), std::streamsize(full * sizeof(Block)));
+  if (rest != 0) {
+    const Block last = symbols.data()[full] & low_mask<Block>(rest);
+    out.write(reinterpret_cast<const char*>(&last), sizeof(last));
+  }
+  out.write(zeros.data(), std::streamsize(h.payload_bytes - bytes));
+}
+
+// Read the offsets and the blocks straight into the storage of s, p names the source in errors.
+template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
+void read_string_set(
+    std::istream& in, XbitStringSet<N, Block, Allocator>& s, const std::filesystem::path& p) {
+  StringSetHeader h;
+  if (!in.read(reinterpret_cast<char*>(&h), sizeof(h))) throw_file_error("truncated header", p);
+  check_header<N, Block>(h, p);
+  s.clear();
+  s.offsets_.resize(h.sequences + 1);
+  s.symbols_.resize(h.size);
+  const auto bytes = (h.size * N + CHAR_BIT - 1) / CHAR_BIT;
+  const auto offsets_bytes = (h.sequences + 1) * sizeof(std::uint64_t);
+  if (!in.read(reinterpret_cast<char*>(s.offsets_.data()), std::streamsize(offsets_bytes)) ||
+      !in.ignore(std::streamsize(h.offsets_bytes() - offsets_bytes)) ||
+      !in.read(reinterpret_cast<char*>(s.symbols_.data()), std::streamsize(bytes)) ||
+      !in.ignore(std::streamsize(h.payload_bytes - bytes))) {
+    s.clear();
+    throw_file_error("truncated payload", p);
+  }
+  const auto& o = s.offsets_;
+  if (o.front() != 0 || o.back() != h.size || !std::ranges::is_sorted(o)) {
+    s.clear();
+    throw_file_error("invalid offsets", p);
+  }
+}
+
+template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
+void save_xbits(const XbitStringSet<N, Block, Allocator>& s, const std::filesystem::path& p) {
+  std::ofstream out(p, std::ios::binary | std::ios::trunc);
+  if (!out) throw_file_error("cannot open for writing", p);
+  write_string_set(s, out);
+  if (!out.flush()) throw_file_error("write failed", p);
+}
+
+template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
+void load_xbits(const std::filesystem::path& p, XbitStringSet<N, Block, Allocator>& s) {
+  std::ifstream in(p, std::ios::binary);
+  if (!in) throw_file_error("cannot open for reading", p);
+  read_string_set(in, s, p);
+}
+
+}  // namespace biomodern::detail
+
+namespace biomodern {
+
+template <
+    std::unsigned_integral Block = std::uint8_t,
+    std::copy_constructible Allocator = std::allocator<Block>>
+using DibitStringSet = detail::XbitStringSet<2, Block, Allocator>;
+
+template <
+    std::unsigned_integral Block = std::uint8_t,
+    std::copy_constructible Allocator = std::allocator<Block>>
+using QuadbitStringSet = detail::XbitStringSet<4, Block, Allocator>;
+
+// Write s to p as one blob, see detail::StringSetHeader.
+template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
+void save(const detail::XbitStringSet<N, Block, Allocator>& s, const std::filesystem::path& p) {
+  detail::save_xbits(s, p);
+}
+
+// Replace the content of s by the one saved in p.
+template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
+void load(const std::filesystem::path& p, detail::XbitStringSet<N, Block, Allocator>& s) {
+  detail::load_xbits(p, s);
+}
+
+// The same blob written to or read from a stream, e.g. to embed it in another archive.
+template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
+void save(const detail::XbitStringSet<N, Block, Allocator>& s, std::ostream& out) {
+  detail::write_string_set(s, out);
+}
+
+template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
+void load(std::istream& in, detail::XbitStringSet<N, Block, Allocator>& s) {
+  detail::read_string_set(in, s, "stream");
+}
+
+}  // namespace biomodern
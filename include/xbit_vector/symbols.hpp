@@ -0,0 +1,376 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstdint>
+
+#include "xbit_vector.hpp"
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+namespace biomodern::detail {
+
+// A symbol mapping lut applied to the 16 nibbles of a byte, a nibble holding one quadbit or two
+// dibits, so that both widths share the byte kernels below.
+template <std::size_t N>
+requires(N == 2 || N == 4) constexpr std::array<std::uint8_t, 16> nibble_table(
+    const std::array<std::uint8_t, (1 << N)>& lut) noexcept {
+  std::array<std::uint8_t, 16> t{};
+  for (std::size_t x = 0; x < t.size(); ++x)
+    if constexpr (N == 4) t[x] = static_cast<std::uint8_t>(lut[x] & 15);
+    else
+      t[x] = static_cast<std::uint8_t>((lut[x & 3] & 3) | (lut[x >> 2] & 3) << 2);
+  return t;
+}
+
+// Map all the xbits of a block. Dibits are selected with masks, the four selections of equal
+// dibits being spread over both bits and merged with the replicated images, quadbits are looked
+// up a nibble at a time.
+template <std::size_t N, std::unsigned_integral Block>
+constexpr Block transform_block(Block x, const std::array<std::uint8_t, 16>& t) noexcept {
+  if constexpr (N == 2) {
+    constexpr Block ones = std::numeric_limits<Block>::max() / 3;
+    const Block lo = x & ones;
+    const Block hi = x >> 1 & ones;
+    const auto select = [&](Block m, std::size_t v) {
+      const Block image = replicate<2, Block>(static_cast<std::uint8_t>(t[v] & 3));
+      return static_cast<Block>((m | m << 1) & image);
+    };
+    return static_cast<Block>(
+        select(static_cast<Block>(~(hi | lo) & ones), 0) |
+        select(static_cast<Block>(~hi & lo), 1) | select(static_cast<Block>(hi & ~lo), 2) |
+        select(static_cast<Block>(hi & lo), 3));
+  } else {
+    Block r = 0;
+    for (std::size_t s = 0; s < block_bits<Block>; s += 4)
+      r |= static_cast<Block>(static_cast<Block>(t[x >> s & 15]) << s);
+    return r;
+  }
+}
+
+#if defined(__SSSE3__)
+inline __m128i transform_nibbles_epi8(__m128i x, __m128i table) noexcept {
+  const __m128i low = _mm_set1_epi8(0x0f);
+  const __m128i lo = _mm_shuffle_epi8(table, _mm_and_si128(x, low));
+  const __m128i hi = _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(x, 4), low));
+  return _mm_or_si128(lo, _mm_slli_epi16(hi, 4));
+}
+#endif
+
+#if defined(__AVX2__)
+inline __m256i transform_nibbles_epi8(__m256i x, __m256i table) noexcept {
+  const __m256i low = _mm256_set1_epi8(0x0f);
+  const __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(x, low));
+  const __m256i hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(x, 4), low));
+  return _mm256_or_si256(lo, _mm256_slli_epi16(hi, 4));
+}
+#endif
+
+// Map both nibbles of every byte of [first, last) through t to d_first, which is either first or
+// does not overlap the range. Bytes hold whole xbits whatever the block width and byte order.
+inline void transform_nibbles(
+    const std::uint8_t* first, const std::uint8_t* last, std::uint8_t* d_first,
+    const std::array<std::uint8_t, 16>& t) noexcept {
+#if defined(__SSSE3__)
+  const __m128i table = _mm_loadu_si128(reinterpret_cast<const __m128i*>(t.data()));
+#endif
+#if defined(__AVX2__)
+  const __m256i table2 = _mm256_broadcastsi128_si256(table);
+  for (; last - first >= 32; first += 32, d_first += 32) {
+    const __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(d_first), transform_nibbles_epi8(x, table2));
+  }
+#endif
+#if defined(__SSSE3__)
+  for (; last - first >= 16; first += 16, d_first += 16) {
+    const __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(d_first), transform_nibbles_epi8(x, table));
+  }
+#endif
+  for (; first != last; ++first, ++d_first)
+    *d_first = static_cast<std::uint8_t>(t[*first & 15] | t[*first >> 4] << 4);
+}
+
+// Map the blocks [first, last) to d_first, which is either first or does not overlap them. Without
+// SSSE3 dibits use the mask arithmetic a whole block at a time, which the compiler vectorizes.
+template <std::size_t N, std::unsigned_integral Block>
+constexpr void transform_blocks(
+    const Block* first, const Block* last, Block* d_first,
+    const std::array<std::uint8_t, 16>& t) noexcept {
+#if defined(__SSSE3__)
+  constexpr bool nibbles = true;
+#else
+  constexpr bool nibbles = N == 4;
+#endif
+  if (nibbles && !std::is_constant_evaluated()) {
+    transform_nibbles(
+        reinterpret_cast<const std::uint8_t*>(first), reinterpret_cast<const std::uint8_t*>(last),
+        reinterpret_cast<std::uint8_t*>(d_first), t);
+    return;
+  }
+  for (; first != last; ++first, ++d_first) *d_first = transform_block<N>(*first, t);
+}
+
+// Map the n bits from bit off < W of src to the same bits of dst, which is either src or does not
+// overlap them: the partial blocks at both ends are merged under masks and the rest is mapped a
+// block at a time.
+template <std::size_t N, std::unsigned_integral Block>
+constexpr void transform_bits(
+    const Block* src, Block* dst, std::size_t off, std::size_t n,
+    const std::array<std::uint8_t, 16>& t) noexcept {
+  constexpr std::size_t W = block_bits<Block>;
+  const auto merge = [&](const Block* s, Block* d, std::size_t o, std::size_t k) {
+    const Block m = static_cast<Block>(low_mask<Block>(k) << o);
+    *d = static_cast<Block>((*d & ~m) | (transform_block<N>(*s, t) & m));
+  };
+  if (n == 0) return;
+  if (off != 0) {
+    const std::size_t k = std::min(W - off, n);
+    merge(src++, dst++, off, k);
+    n -= k;
+  }
+  const std::size_t nb = n / W;
+  transform_blocks<N>(src, src + nb, dst, t);
+  if (n %= W) merge(src + nb, dst + nb, 0, n);
+}
+
+// Replace every xbit x of [first, last) with lut[x].
+template <std::size_t N, std::unsigned_integral Block>
+requires(N == 2 || N == 4) constexpr void transform_symbols(
+    XbitIterator<N, Block> first, XbitIterator<N, Block> last,
+    const std::array<std::uint8_t, (1 << N)>& lut) noexcept {
+  transform_bits<N>(
+      first.segment(), first.segment(), first.bit_offset(), (last - first) * N,
+      nibble_table<N>(lut));
+}
+
+// Write lut[x] for every xbit x of [first, last) to d_first, the ranges must not overlap unless
+// they coincide. A destination at another offset in its block is block-copied first and then
+// mapped in place.
+template <std::size_t N, std::unsigned_integral Block>
+requires(N == 2 || N == 4) constexpr XbitIterator<N, Block> transform_symbols(
+    XbitConstIterator<N, Block> first, XbitConstIterator<N, Block> last,
+    XbitIterator<N, Block> d_first, const std::array<std::uint8_t, (1 << N)>& lut) noexcept {
+  const auto n = last - first;
+  if (first.bit_offset() == d_first.bit_offset())
+    transform_bits<N>(
+        first.segment(), d_first.segment(), first.bit_offset(), n * N, nibble_table<N>(lut));
+  else {
+    copy(first, last, d_first);
+    transform_symbols(d_first, d_first + n, lut);
+  }
+  return d_first + n;
+}
+
+template <std::size_t N, std::unsigned_integral Block>
+requires(N == 2 || N == 4) constexpr XbitIterator<N, Block> transform_symbols(
+    XbitIterator<N, Block> first, XbitIterator<N, Block> last, XbitIterator<N, Block> d_first,
+    const std::array<std::uint8_t, (1 << N)>& lut) noexcept {
+  return transform_symbols(
+      XbitConstIterator<N, Block>(first), XbitConstIterator<N, Block>(last), d_first, lut);
+}
+
+// How a dibit d is held in a quadbit by widen and read back by narrow: as the value d, or as the
+// IUPAC code 1 << d of pack_iupac, A = 1, C = 2, G = 4 and T = 8.
+enum class DibitEncoding { zero_extended, one_hot };
+
+// Deposit the 16 dibits of x into the low two bits of 16 nibbles, PDEP does it in one step.
+constexpr std::uint64_t deposit_dibits(std::uint32_t x) noexcept {
+  constexpr std::uint64_t m = 0x3333333333333333;
+#if defined(__BMI2__)
+  if (!std::is_constant_evaluated()) return _pdep_u64(x, m);
+#endif
+  std::uint64_t r = x;
+  r = (r | r << 16) & 0x0000ffff0000ffff;
+  r = (r | r << 8) & 0x00ff00ff00ff00ff;
+  r = (r | r << 4) & 0x0f0f0f0f0f0f0f0f;
+  return (r | r << 2) & m;
+}
+
+// The reverse, gather the low two bits of the 16 nibbles of x, PEXT does it in one step.
+constexpr std::uint32_t extract_dibits(std::uint64_t x) noexcept {
+  constexpr std::uint64_t m = 0x3333333333333333;
+#if defined(__BMI2__)
+  if (!std::is_constant_evaluated()) return static_cast<std::uint32_t>(_pext_u64(x, m));
+#endif
+  x &= m;
+  x = (x | x >> 2) & 0x0f0f0f0f0f0f0f0f;
+  x = (x | x >> 4) & 0x00ff00ff00ff00ff;
+  x = (x | x >> 8) & 0x0000ffff0000ffff;
+  return static_cast<std::uint32_t>(x | x >> 16);
+}
+
+// Encode the 16 zero-extended dibits of x as quadbits.
+constexpr std::uint64_t encode_quadbits(std::uint64_t x, DibitEncoding e) noexcept {
+  if (e == DibitEncoding::zero_extended) return x;
+  constexpr std::uint64_t ones = 0x1111111111111111;
+  const std::uint64_t lo = x & ones;
+  const std::uint64_t hi = x >> 1 & ones;
+  return (~(hi | lo) & ones) | (~hi & lo) << 1 | (hi & ~lo) << 2 | (hi & lo) << 3;
+}
+
+// Decode the 16 quadbits of x to zero-extended dibits. The low bit of the quadbits which are not
+// an encoded dibit is set in invalid, and those decode to A.
+constexpr std::uint64_t decode_quadbits(
+    std::uint64_t x, DibitEncoding e, std::uint64_t& invalid) noexcept {
+  constexpr std::uint64_t ones = 0x1111111111111111;
+  std::uint64_t d;
+  if (e == DibitEncoding::zero_extended) {
+    invalid = (x >> 2 | x >> 3) & ones;
+    d = x;
+  } else {
+    // Exactly one bit is set, the dibit is the position of that bit.
+    const std::uint64_t b1 = x >> 1 & ones, b2 = x >> 2 & ones, b3 = x >> 3 & ones;
+    const std::uint64_t wrong = ((x & ones) + b1 + b2 + b3) ^ ones;
+    invalid = (wrong | wrong >> 1 | wrong >> 2) & ones;
+    d = (b1 | b3) | (b2 | b3) << 1;
+  }
+  return d & ~(invalid * 0xf);
+}
+
+// Write the quadbits encoding the dibits of [first, last) to d_first. The dibits are read 32 at a
+// time, wherever they start, and deposited into two 64-bit words of quadbits.
+template <std::unsigned_integral Block>
+constexpr XbitIterator<4, Block> widen(
+    XbitConstIterator<2, Block> first, XbitConstIterator<2, Block> last,
+    XbitIterator<4, Block> d_first, DibitEncoding e = DibitEncoding::zero_extended) noexcept {
+  const std::size_t n = last - first;
+  const std::size_t src = first.bit_offset(), dst = d_first.bit_offset();
+  for (std::size_t i = 0; i < n; i += 32) {
+    const std::size_t k = std::min<std::size_t>(n - i, 32);
+    const std::uint64_t x = load_bits64(first.segment(), src + 2 * i, 2 * k);
+    const std::uint64_t lo = encode_quadbits(deposit_dibits(static_cast<std::uint32_t>(x)), e);
+    store_bits64(d_first.segment(), dst + 4 * i, std::min<std::size_t>(4 * k, 64), lo);
+    if (k > 16) {
+      const std::uint64_t hi =
+          encode_quadbits(deposit_dibits(static_cast<std::uint32_t>(x >> 32)), e);
+      store_bits64(d_first.segment(), dst + 4 * i + 64, 4 * k - 64, hi);
+    }
+  }
+  return d_first + n;
+}
+
+template <std::unsigned_integral Block>
+constexpr XbitIterator<4, Block> widen(
+    XbitIterator<2, Block> first, XbitIterator<2, Block> last, XbitIterator<4, Block> d_first,
+    DibitEncoding e = DibitEncoding::zero_extended) noexcept {
+  return widen(XbitConstIterator<2, Block>(first), XbitConstIterator<2, Block>(last), d_first, e);
+}
+
+// Write the dibits encoded by the quadbits of [first, last) to d_first, calling f(i) for every
+// quadbit first[i] which encodes none, those are written as A. Returns their number. Quadbits are
+// decoded with masks and extracted 16 at a time, the invalid ones are located with
+// count-trailing-zeros.
+template <std::unsigned_integral Block, std::invocable<std::size_t> F>
+constexpr std::size_t narrow(
+    XbitConstIterator<4, Block> first, XbitConstIterator<4, Block> last,
+    XbitIterator<2, Block> d_first, DibitEncoding e, F f) {
+  const std::size_t n = last - first;
+  const std::size_t src = first.bit_offset(), dst = d_first.bit_offset();
+  std::size_t r = 0;
+  // Two words of quadbits make one word of dibits, so that narrow blocks are stored whole.
+  for (std::size_t i = 0; i < n; i += 32) {
+    std::uint64_t x = 0;
+    for (std::size_t j = i; j < std::min(n, i + 32); j += 16) {
+      const std::size_t k = std::min<std::size_t>(n - j, 16);
+      std::uint64_t invalid;
+      const std::uint64_t y =
+          decode_quadbits(load_bits64(first.segment(), src + 4 * j, 4 * k), e, invalid);
+      x |= std::uint64_t{extract_dibits(y)} << 2 * (j - i);
+      // Quadbits past the range are zero, which is a dibit when zero-extended but not one-hot.
+      invalid &= low_mask<std::uint64_t>(4 * k);
+      for (r += static_cast<std::size_t>(std::popcount(invalid)); invalid; invalid &= invalid - 1)
+        f(j + static_cast<std::size_t>(std::countr_zero(invalid)) / 4);
+    }
+    store_bits64(d_first.segment(), dst + 2 * i, 2 * std::min<std::size_t>(n - i, 32), x);
+  }
+  return r;
+}
+
+template <std::unsigned_integral Block, std::invocable<std::size_t> F>
+constexpr std::size_t narrow(
+    XbitIterator<4, Block> first, XbitIterator<4, Block> last, XbitIterator<2, Block> d_first,
+    DibitEncoding e, F f) {
+  return narrow(
+      XbitConstIterator<4, Block>(first), XbitConstIterator<4, Block>(last), d_first, e, f);
+}
+
+}  // namespace biomodern::detail
+
+namespace biomodern {
+
+// Resize dst to src.size() and write lut[x] for every xbit x of src to it, dst may be src.
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+requires(N == 2 || N == 4) constexpr void transform_symbols(
+    const detail::XbitVector<N, Block, Allocator, InlineBlocks>& src,
+    detail::XbitVector<N, Block, Allocator, InlineBlocks>& dst,
+    const std::array<std::uint8_t, (1 << N)>& lut) {
+  dst.resize(src.size());
+  detail::transform_symbols(src.begin(), src.end(), dst.begin(), lut);
+}
+
+// Replace every xbit x of v with lut[x], e.g. {3, 2, 1, 0} complements dibits.
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+requires(N == 2 || N == 4) constexpr void transform_symbols(
+    detail::XbitVector<N, Block, Allocator, InlineBlocks>& v,
+    const std::array<std::uint8_t, (1 << N)>& lut) noexcept {
+  detail::transform_symbols(v.begin(), v.end(), lut);
+}
+
+// Overwrite the first src.size() <= dst.size() xbits of dst.
+template <std::size_t N, typename Block, std::unsigned_integral B>
+requires((N == 2 || N == 4) && std::same_as<std::remove_const_t<Block>, B>)
+constexpr void transform_symbols(
+    XbitSpan<N, Block> src, XbitSpan<N, B> dst,
+    const std::array<std::uint8_t, (1 << N)>& lut) noexcept {
+  assert(src.size() <= dst.size());
+  detail::transform_symbols(src.cbegin(), src.cend(), dst.begin(), lut);
+}
+
+template <std::size_t N, std::unsigned_integral Block>
+requires(N == 2 || N == 4) constexpr void transform_symbols(
+    XbitSpan<N, Block> s, const std::array<std::uint8_t, (1 << N)>& lut) noexcept {
+  detail::transform_symbols(s.begin(), s.end(), lut);
+}
+
+using DibitEncoding = detail::DibitEncoding;
+
+// The quadbits encoding the dibits of v, in a vector of the same block type and allocator.
+template <std::unsigned_integral Block, std::copy_constructible Allocator, std::size_t InlineBlocks>
+constexpr detail::XbitVector<4, Block, Allocator, InlineBlocks> widen(
+    const detail::XbitVector<2, Block, Allocator, InlineBlocks>& v,
+    DibitEncoding e = DibitEncoding::zero_extended) {
+  detail::XbitVector<4, Block, Allocator, InlineBlocks> r(v.get_allocator());
+  r.resize_for_overwrite(v.size());
+  detail::widen(v.begin(), v.end(), r.begin(), e);
+  return r;
+}
+
+// The dibits encoded by the quadbits of v, f(i) is called for every v[i] which encodes none and
+// is narrowed to A, e.g. to collect ambiguous bases.
+template <
+    std::unsigned_integral Block, std::copy_constructible Allocator, std::size_t InlineBlocks,
+    std::invocable<std::size_t> F>
+constexpr detail::XbitVector<2, Block, Allocator, InlineBlocks> narrow(
+    const detail::XbitVector<4, Block, Allocator, InlineBlocks>& v, DibitEncoding e, F f) {
+  detail::XbitVector<2, Block, Allocator, InlineBlocks> r(v.get_allocator());
+  r.resize_for_overwrite(v.size());
+  detail::narrow(v.begin(), v.end(), r.begin(), e, f);
+  return r;
+}
+
+template <std::unsigned_integral Block, std::copy_constructible Allocator, std::size_t InlineBlocks>
+constexpr detail::XbitVector<2, Block, Allocator, InlineBlocks> narrow(
+    const detail::XbitVector<4, Block, Allocator, InlineBlocks>& v,
+    DibitEncoding e = DibitEncoding::zero_extended) {
+  return narrow(v, e, [](std::size_t) {});
+}
+
+}  // namespace biomodern
@@ -1,75 +1,132 @@
 #pragma once
 
+#include <algorithm>
+#include <array>
+#include <bit>
 #include <cassert>
 #include <climits>
+#include <compare>
 #include <concepts>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
 #include <limits>
+#include <memory>
+#include <memory_resource>
+#include <ranges>
+#include <span>
 #include <stdexcept>
+#include <utility>
+
+#if defined(__SSE2__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
 
 namespace biomodern::detail {
 
+template <std::unsigned_integral Block>
+constexpr std::size_t block_bits = sizeof(Block) * CHAR_BIT;
+
+// Mask of the k low bits of a block, 0 <= k <= block_bits.
+template <std::unsigned_integral Block>
+constexpr Block low_mask(std::size_t k) noexcept {
+  return k < block_bits<Block> ? static_cast<Block>((Block{1} << k) - 1)
+                               : std::numeric_limits<Block>::max();
+}
+
+// Xbits tile the blocks when N divides the block width. Otherwise they are packed back to back
+// and straddle block boundaries, up to three blocks for N = 16 in std::uint8_t.
+template <std::size_t N, std::unsigned_integral Block>
+constexpr bool tiled_xbits = block_bits<Block> % N == 0;
+
+// The value of an xbit, N <= 16.
+template <std::size_t N>
+using xbit_t = std::conditional_t<(N <= 8), std::uint8_t, std::uint16_t>;
+
 template <std::size_t N, std::unsigned_integral Block>
 class XbitReference {
  public:
-  constexpr static Block mask =
-      (std::numeric_limits<Block>::max() >> (sizeof(Block) * CHAR_BIT - N));
+  typedef xbit_t<N> value_type;
+
+  constexpr static value_type mask = static_cast<value_type>(low_mask<std::uint64_t>(N));
 
  private:
   Block* seg_;
   const std::size_t shift_;
 
  public:
+  // offset counts xbits when they tile the blocks and bits otherwise.
   constexpr XbitReference(Block* seg, std::size_t offset) noexcept
-      : seg_(seg), shift_(offset * N) {}
+      : seg_(seg), shift_(tiled_xbits<N, Block> ? offset * N : offset) {}
 
-  constexpr operator std::uint8_t() const noexcept { return *seg_ >> shift_ & mask; }
+  constexpr operator value_type() const noexcept {
+    if constexpr (tiled_xbits<N, Block>) return static_cast<value_type>(*seg_ >> shift_ & mask);
+    else {
+      // Up to three blocks for N > 8 in std::uint8_t, two otherwise.
+      constexpr std::size_t W = block_bits<Block>;
+      std::uint64_t v = *seg_ >> shift_;
+      if (shift_ + N > W) v |= std::uint64_t{seg_[1]} << (W - shift_);
+      if (N > W && shift_ + N > 2 * W) v |= std::uint64_t{seg_[2]} << (2 * W - shift_);
+      return static_cast<value_type>(v & mask);
+    }
+  }
 
   constexpr XbitReference& operator++() noexcept { return operator=(*this + 1); }
 
-  constexpr std::uint8_t operator++(int) noexcept {
-    std::uint8_t tmp = *this;
+  constexpr value_type operator++(int) noexcept {
+    value_type tmp = *this;
     ++*this;
     return tmp;
   }
 
   constexpr XbitReference& operator--() noexcept { return operator=(*this - 1); }
 
-  constexpr std::uint8_t operator--(int) noexcept {
-    std::uint8_t tmp = *this;
+  constexpr value_type operator--(int) noexcept {
+    value_type tmp = *this;
     --*this;
     return tmp;
   }
 
-  constexpr XbitReference& operator=(std::uint8_t x) noexcept {
-    *seg_ &= ~(mask << shift_);
-    *seg_ |= (x & mask) << shift_;
+  constexpr XbitReference& operator=(value_type x) noexcept {
+    if constexpr (tiled_xbits<N, Block>) {
+      *seg_ &= ~(Block{mask} << shift_);
+      *seg_ |= (x & Block{mask}) << shift_;
+    } else {
+      constexpr std::size_t W = block_bits<Block>;
+      const std::uint64_t m = mask, v = x & mask;
+      seg_[0] = static_cast<Block>((seg_[0] & ~(m << shift_)) | v << shift_);
+      if (shift_ + N > W)
+        seg_[1] = static_cast<Block>((seg_[1] & ~(m >> (W - shift_))) | v >> (W - shift_));
+      if (N > W && shift_ + N > 2 * W)
+        seg_[2] = static_cast<Block>((seg_[2] & ~(m >> (2 * W - shift_))) | v >> (2 * W - shift_));
+    }
     return *this;
   }
 
   constexpr XbitReference& operator=(const XbitReference& x) noexcept {
-    return operator=(static_cast<std::uint8_t>(x));
+    return operator=(static_cast<value_type>(x));
   }
 
-  constexpr void operator=(std::uint8_t) const noexcept {}
+  constexpr void operator=(value_type) const noexcept {}
 };
 
 template <std::size_t N, std::unsigned_integral Block>
 inline void swap(XbitReference<N, Block> x, XbitReference<N, Block> y) noexcept {
-  std::uint8_t t = x;
+  xbit_t<N> t = x;
   x = y;
   y = t;
 }
 
 template <std::size_t N, std::unsigned_integral Block>
-inline void swap(XbitReference<N, Block> x, std::uint8_t& y) noexcept {
-  std::uint8_t t = x;
+inline void swap(XbitReference<N, Block> x, xbit_t<N>& y) noexcept {
+  xbit_t<N> t = x;
   x = y;
   y = t;
 }
 
 template <std::size_t N, std::unsigned_integral Block>
-inline void swap(std::uint8_t& x, XbitReference<N, Block> y) noexcept {
-  std::uint8_t t = x;
+inline void swap(xbit_t<N>& x, XbitReference<N, Block> y) noexcept {
+  xbit_t<N> t = x;
   x = y;
   y = t;
 }
@@ -78,11 +135,14 @@ template <std::size_t N, std::unsigned_integral Block>
 class XbitIteratorBase {
  public:
   typedef std::random_access_iterator_tag iterator_category;
-  typedef std::uint8_t value_type;
+  typedef xbit_t<N> value_type;
   typedef std::ptrdiff_t difference_type;
   typedef void pointer;
 
-  constexpr static std::size_t xbits_per_block = sizeof(Block) * CHAR_BIT / N;
+  // Whole xbits per block. When N does not divide the block width the xbits are packed back to
+  // back instead, n blocks then hold n * block_bits / N of them and offsets count bits.
+  constexpr static std::size_t xbits_per_block = block_bits<Block> / N;
+  constexpr static bool tiled = tiled_xbits<N, Block>;
 
  protected:
   Block* seg_;
@@ -93,9 +153,20 @@ class XbitIteratorBase {
       : seg_(seg), offset_(offset) {}
 
   constexpr friend difference_type operator-(const XbitIteratorBase& x, const XbitIteratorBase& y) {
-    return (x.seg_ - y.seg_) * xbits_per_block + x.offset_ - y.offset_;
+    if constexpr (tiled) return (x.seg_ - y.seg_) * xbits_per_block + x.offset_ - y.offset_;
+    else
+      return ((x.seg_ - y.seg_) * static_cast<difference_type>(block_bits<Block>) +
+              static_cast<difference_type>(x.offset_) - static_cast<difference_type>(y.offset_)) /
+             static_cast<difference_type>(N);
   }
 
+  constexpr Block* segment() const noexcept { return seg_; }
+
+  constexpr std::size_t offset() const noexcept { return offset_; }
+
+  // Offset of the first bit of the xbit in its block.
+  constexpr std::size_t bit_offset() const noexcept { return tiled ? offset_ * N : offset_; }
+
   constexpr bool operator==(const XbitIteratorBase& other) const noexcept = default;
 
   constexpr auto operator<=>(const XbitIteratorBase& other) const noexcept {
@@ -105,7 +176,9 @@ class XbitIteratorBase {
 
  protected:
   constexpr void bump_up() {
-    if (offset_ != xbits_per_block - 1) ++offset_;
+    if constexpr (!tiled) incr(1);
+    else if (offset_ != xbits_per_block - 1)
+      ++offset_;
     else {
       offset_ = 0;
       ++seg_;
@@ -113,7 +186,9 @@ class XbitIteratorBase {
   }
 
   constexpr void bump_down() {
-    if (offset_ != 0) --offset_;
+    if constexpr (!tiled) incr(-1);
+    else if (offset_ != 0)
+      --offset_;
     else {
       offset_ = xbits_per_block - 1;
       --seg_;
@@ -121,6 +196,15 @@ class XbitIteratorBase {
   }
 
   constexpr void incr(difference_type n) {
+    if constexpr (!tiled) {
+      // The block width is a power of two, the shift rounds towards minus infinity.
+      constexpr std::size_t W = block_bits<Block>;
+      const difference_type bits = static_cast<difference_type>(offset_) +
+                                   n * static_cast<difference_type>(N);
+      seg_ += bits >> std::countr_zero(W);
+      offset_ = static_cast<std::size_t>(bits) & (W - 1);
+      return;
+    }
     if (n >= 0) seg_ += (n + offset_) / xbits_per_block;
     else
       seg_ += static_cast<difference_type>(n - xbits_per_block + offset_ + 1) /
@@ -267,6 +351,931 @@ struct XbitConstIterator : public XbitIteratorBase<N, Block> {
   }
 };
 
+// Read k bits (0 < k <= block_bits) starting at bit off of p, the next block is touched only
+// when the bits straddle the boundary.
+template <std::unsigned_integral Block>
+constexpr Block load_bits(const Block* p, std::size_t off, std::size_t k) noexcept {
+  Block r = static_cast<Block>(p[0] >> off);
+  if (off + k > block_bits<Block>) r |= static_cast<Block>(p[1] << (block_bits<Block> - off));
+  return r & low_mask<Block>(k);
+}
+
+template <std::unsigned_integral Block>
+constexpr void store_bits(Block* p, std::size_t off, std::size_t k, Block v) noexcept {
+  const Block m = low_mask<Block>(k);
+  v &= m;
+  p[0] = static_cast<Block>((p[0] & ~(m << off)) | (v << off));
+  if (off + k > block_bits<Block>) {
+    const std::size_t s = block_bits<Block> - off;
+    p[1] = static_cast<Block>((p[1] & ~(m >> s)) | (v >> s));
+  }
+}
+
+// Copy n bits from (src, so) to (dst, dOff) from front to back, whole blocks are moved at once
+// when both offsets agree and shifted-and-merged from two adjacent source blocks otherwise.
+template <std::unsigned_integral Block>
+constexpr void copy_bits(
+    const Block* src, std::size_t so, Block* dst, std::size_t dOff, std::size_t n) noexcept {
+  constexpr std::size_t W = block_bits<Block>;
+  if (n == 0) return;
+  if (so == dOff) {
+    if (so != 0) {
+      const std::size_t k = std::min(W - so, n);
+      const Block m = static_cast<Block>(low_mask<Block>(k) << so);
+      *dst = static_cast<Block>((*dst & ~m) | (*src & m));
+      n -= k;
+      ++src;
+      ++dst;
+    }
+    const std::size_t nb = n / W;
+    dst = std::copy(src, src + nb, dst);
+    src += nb;
+    if (n %= W) {
+      const Block m = low_mask<Block>(n);
+      *dst = static_cast<Block>((*dst & ~m) | (*src & m));
+    }
+    return;
+  }
+  if (dOff != 0) {
+    const std::size_t k = std::min(W - dOff, n);
+    store_bits(dst, dOff, k, load_bits(src, so, k));
+    n -= k;
+    ++dst;
+    so += k;
+    src += so / W;
+    so %= W;
+  }
+  for (; n >= W; n -= W, ++src, ++dst)
+    *dst = static_cast<Block>(*src >> so | src[1] << (W - so));
+  if (n) store_bits(dst, 0, n, load_bits(src, so, n));
+}
+
+// Same as copy_bits but from back to front, for destinations overlapping the source tail.
+template <std::unsigned_integral Block>
+constexpr void copy_bits_backward(
+    const Block* src, std::size_t so, Block* dst, std::size_t dOff, std::size_t n) noexcept {
+  constexpr std::size_t W = block_bits<Block>;
+  std::size_t se = so + n;
+  std::size_t de = dOff + n;
+  if (so == dOff) {
+    if (const std::size_t r = de % W; r != 0 && n != 0) {
+      const std::size_t k = std::min(r, n);
+      const Block m = static_cast<Block>(low_mask<Block>(k) << (r - k));
+      Block& d = dst[de / W];
+      d = static_cast<Block>((d & ~m) | (src[se / W] & m));
+      n -= k;
+      se -= k;
+      de -= k;
+    }
+    const std::size_t nb = n / W;
+    std::copy_backward(src + se / W - nb, src + se / W, dst + de / W);
+    n -= nb * W;
+    if (n) {
+      const Block m = static_cast<Block>(low_mask<Block>(n) << (W - n));
+      Block& d = dst[de / W - nb - 1];
+      d = static_cast<Block>((d & ~m) | (src[se / W - nb - 1] & m));
+    }
+    return;
+  }
+  while (n) {
+    const std::size_t r = de % W;
+    const std::size_t k = std::min(r != 0 ? r : W, n);
+    de -= k;
+    se -= k;
+    store_bits(dst + de / W, de % W, k, load_bits(src + se / W, se % W, k));
+    n -= k;
+  }
+}
+
+template <std::unsigned_integral Block>
+constexpr void swap_bits(
+    Block* a, std::size_t ao, Block* b, std::size_t bo, std::size_t n) noexcept {
+  constexpr std::size_t W = block_bits<Block>;
+  if (n == 0) return;
+  if (ao == bo) {
+    if (ao != 0) {
+      const std::size_t k = std::min(W - ao, n);
+      const Block m = static_cast<Block>(low_mask<Block>(k) << ao);
+      const Block t = *a;
+      *a = static_cast<Block>((*a & ~m) | (*b & m));
+      *b = static_cast<Block>((*b & ~m) | (t & m));
+      n -= k;
+      ++a;
+      ++b;
+    }
+    const std::size_t nb = n / W;
+    std::swap_ranges(a, a + nb, b);
+    a += nb;
+    b += nb;
+    if (n %= W) {
+      const Block m = low_mask<Block>(n);
+      const Block t = *a;
+      *a = static_cast<Block>((*a & ~m) | (*b & m));
+      *b = static_cast<Block>((*b & ~m) | (t & m));
+    }
+    return;
+  }
+  while (n) {
+    const std::size_t k = std::min(W - bo, n);
+    const Block x = load_bits(a, ao, k);
+    const Block y = load_bits(b, bo, k);
+    store_bits(a, ao, k, y);
+    store_bits(b, bo, k, x);
+    n -= k;
+    ao += k;
+    a += ao / W;
+    ao %= W;
+    ++b;
+    bo = 0;
+  }
+}
+
+// Read k bits (0 < k <= 64) starting at bit pos of the block array p, only the blocks holding
+// those bits are touched. Little-endian targets read the bytes directly whatever the block width.
+template <std::unsigned_integral Block>
+constexpr std::uint64_t load_bits64(const Block* p, std::size_t pos, std::size_t k) noexcept {
+  constexpr std::size_t W = block_bits<Block>;
+  if constexpr (W >= 64) return load_bits(p + pos / W, pos % W, k);
+  else {
+    if (std::endian::native == std::endian::little && !std::is_constant_evaluated()) {
+      const auto* bytes = reinterpret_cast<const unsigned char*>(p) + pos / CHAR_BIT;
+      const std::size_t r = pos % CHAR_BIT;
+      const std::size_t n = (r + k + CHAR_BIT - 1) / CHAR_BIT;
+      std::uint64_t lo = 0;
+      if (n >= 8) std::memcpy(&lo, bytes, 8);
+      else
+        for (std::size_t j = 0; j < n; ++j) lo |= std::uint64_t{bytes[j]} << (j * CHAR_BIT);
+      std::uint64_t v = lo >> r;
+      if (n > 8) v |= std::uint64_t{bytes[8]} << (64 - r);
+      return k < 64 ? v & ((std::uint64_t{1} << k) - 1) : v;
+    }
+    std::uint64_t v = 0;
+    for (std::size_t i = 0; i < k;) {
+      const std::size_t b = pos + i;
+      const std::size_t c = std::min(W - b % W, k - i);
+      v |= std::uint64_t{load_bits(p + b / W, b % W, c)} << i;
+      i += c;
+    }
+    return v;
+  }
+}
+
+template <std::unsigned_integral Block>
+constexpr void store_bits64(Block* p, std::size_t pos, std::size_t k, std::uint64_t v) noexcept {
+  constexpr std::size_t W = block_bits<Block>;
+  if constexpr (W >= 64) store_bits(p + pos / W, pos % W, k, static_cast<Block>(v));
+  else {
+    if (std::endian::native == std::endian::little && !std::is_constant_evaluated()) {
+      auto* bytes = reinterpret_cast<unsigned char*>(p) + pos / CHAR_BIT;
+      const std::size_t r = pos % CHAR_BIT;
+      const std::uint64_t m = k < 64 ? (std::uint64_t{1} << k) - 1 : ~std::uint64_t{0};
+      v &= m;
+      if (r == 0 && k == 64) {
+        std::memcpy(bytes, &v, 8);
+        return;
+      }
+      const std::size_t n = (r + k + CHAR_BIT - 1) / CHAR_BIT;
+      std::uint64_t lo = 0;
+      std::memcpy(&lo, bytes, std::min<std::size_t>(n, 8));
+      lo = (lo & ~(m << r)) | v << r;
+      std::memcpy(bytes, &lo, std::min<std::size_t>(n, 8));
+      if (n > 8) {
+        const unsigned hm = static_cast<unsigned>(m >> (64 - r));
+        bytes[8] = static_cast<unsigned char>((bytes[8] & ~hm) | (v >> (64 - r)));
+      }
+      return;
+    }
+    for (std::size_t i = 0; i < k;) {
+      const std::size_t b = pos + i;
+      const std::size_t c = std::min(W - b % W, k - i);
+      store_bits(p + b / W, b % W, c, static_cast<Block>(v >> i));
+      i += c;
+    }
+  }
+}
+
+// load_bits64 and store_bits64 for little-endian callers which know that the 9 bytes from the
+// one holding bit pos lie within their blocks: one unaligned word and one byte are accessed
+// whatever the offset and length, without branches.
+inline std::uint64_t load_bits64_unchecked(
+    const unsigned char* bytes, std::size_t pos, std::size_t k) noexcept {
+  const std::size_t r = pos % CHAR_BIT;
+  std::uint64_t lo;
+  std::memcpy(&lo, bytes + pos / CHAR_BIT, 8);
+  const std::uint64_t hi = bytes[pos / CHAR_BIT + 8];
+  return (lo >> r | hi << 1 << (63 - r)) & ~std::uint64_t{0} >> (64 - k);
+}
+
+inline void store_bits64_unchecked(
+    unsigned char* bytes, std::size_t pos, std::size_t k, std::uint64_t v) noexcept {
+  const std::size_t r = pos % CHAR_BIT;
+  const std::uint64_t m = ~std::uint64_t{0} >> (64 - k);
+  v &= m;
+  std::uint64_t lo;
+  std::memcpy(&lo, bytes + pos / CHAR_BIT, 8);
+  lo = (lo & ~(m << r)) | v << r;
+  std::memcpy(bytes + pos / CHAR_BIT, &lo, 8);
+  auto& hi = bytes[pos / CHAR_BIT + 8];
+  hi = static_cast<unsigned char>((hi & ~(m >> 1 >> (63 - r))) | v >> 1 >> (63 - r));
+}
+
+// Set n bits starting at bit off of dst to the corresponding bits of the block-wide pattern,
+// only the partial head and tail blocks are merged.
+template <std::unsigned_integral Block>
+constexpr void fill_bits(Block* dst, std::size_t off, std::size_t n, Block pattern) noexcept {
+  constexpr std::size_t W = block_bits<Block>;
+  if (n == 0) return;
+  if (off != 0) {
+    const std::size_t k = std::min(W - off, n);
+    const Block m = static_cast<Block>(low_mask<Block>(k) << off);
+    *dst = static_cast<Block>((*dst & ~m) | (pattern & m));
+    n -= k;
+    ++dst;
+  }
+  dst = std::fill_n(dst, n / W, pattern);
+  if (n %= W) {
+    const Block m = low_mask<Block>(n);
+    *dst = static_cast<Block>((*dst & ~m) | (pattern & m));
+  }
+}
+
+// Number of leading bits equal in the n bits starting at (a, ao) and (b, bo), that is n or the
+// index of the first differing bit, which is found with XOR plus count-trailing-zeros since the
+// first element lives in the low bits of a block.
+template <std::unsigned_integral Block>
+constexpr std::size_t mismatch_bits(
+    const Block* a, std::size_t ao, const Block* b, std::size_t bo, std::size_t n) noexcept {
+  constexpr std::size_t W = block_bits<Block>;
+  std::size_t i = 0;
+  if (ao == bo) {
+    if (ao != 0 && n != 0) {
+      const std::size_t k = std::min(W - ao, n);
+      if (const Block d = static_cast<Block>((*a ^ *b) >> ao) & low_mask<Block>(k))
+        return std::countr_zero(d);
+      i = k;
+      ++a;
+      ++b;
+    }
+    for (; n - i >= W; i += W, ++a, ++b)
+      if (const Block d = *a ^ *b) return i + std::countr_zero(d);
+    if (i < n)
+      if (const Block d = (*a ^ *b) & low_mask<Block>(n - i)) return i + std::countr_zero(d);
+    return n;
+  }
+  while (i < n) {
+    const std::size_t k = std::min(W - bo, n - i);
+    if (const Block d = load_bits(a, ao, k) ^ load_bits(b, bo, k))
+      return i + std::countr_zero(d);
+    i += k;
+    ao += k;
+    a += ao / W;
+    ao %= W;
+    ++b;
+    bo = 0;
+  }
+  return n;
+}
+
+template <std::size_t N, std::unsigned_integral Block>
+constexpr XbitIterator<N, Block> copy(
+    XbitConstIterator<N, Block> first, XbitConstIterator<N, Block> last,
+    XbitIterator<N, Block> result) noexcept {
+  const auto n = last - first;
+  copy_bits(first.segment(), first.bit_offset(), result.segment(), result.bit_offset(), n * N);
+  return result + n;
+}
+
+template <std::size_t N, std::unsigned_integral Block>
+constexpr XbitIterator<N, Block> copy(
+    XbitIterator<N, Block> first, XbitIterator<N, Block> last,
+    XbitIterator<N, Block> result) noexcept {
+  return copy(XbitConstIterator<N, Block>(first), XbitConstIterator<N, Block>(last), result);
+}
+
+template <std::size_t N, std::unsigned_integral Block>
+constexpr XbitIterator<N, Block> copy_backward(
+    XbitConstIterator<N, Block> first, XbitConstIterator<N, Block> last,
+    XbitIterator<N, Block> result) noexcept {
+  const auto n = last - first;
+  result -= n;
+  copy_bits_backward(
+      first.segment(), first.bit_offset(), result.segment(), result.bit_offset(), n * N);
+  return result;
+}
+
+template <std::size_t N, std::unsigned_integral Block>
+constexpr XbitIterator<N, Block> copy_backward(
+    XbitIterator<N, Block> first, XbitIterator<N, Block> last,
+    XbitIterator<N, Block> result) noexcept {
+  return copy_backward(
+      XbitConstIterator<N, Block>(first), XbitConstIterator<N, Block>(last), result);
+}
+
+template <std::size_t N, std::unsigned_integral Block>
+constexpr XbitIterator<N, Block> move(
+    XbitIterator<N, Block> first, XbitIterator<N, Block> last,
+    XbitIterator<N, Block> result) noexcept {
+  return copy(first, last, result);
+}
+
+template <std::size_t N, std::unsigned_integral Block>
+constexpr XbitIterator<N, Block> move_backward(
+    XbitIterator<N, Block> first, XbitIterator<N, Block> last,
+    XbitIterator<N, Block> result) noexcept {
+  return copy_backward(first, last, result);
+}
+
+template <std::size_t N, std::unsigned_integral Block>
+constexpr XbitIterator<N, Block> swap_ranges(
+    XbitIterator<N, Block> first1, XbitIterator<N, Block> last1,
+    XbitIterator<N, Block> first2) noexcept {
+  const auto n = last1 - first1;
+  swap_bits(first1.segment(), first1.bit_offset(), first2.segment(), first2.bit_offset(), n * N);
+  return first2 + n;
+}
+
+template <std::size_t N, std::unsigned_integral Block>
+constexpr XbitIterator<N, Block> rotate(
+    XbitIterator<N, Block> first, XbitIterator<N, Block> middle,
+    XbitIterator<N, Block> last) noexcept {
+  constexpr std::size_t buffer_blocks = 128 / sizeof(Block);
+  constexpr std::ptrdiff_t capacity = buffer_blocks * block_bits<Block> / N;
+  auto d1 = middle - first;
+  auto d2 = last - middle;
+  auto r = first + d2;
+  while (d1 != 0 && d2 != 0) {
+    if (d1 <= d2) {
+      if (d1 <= capacity) {
+        Block buf[buffer_blocks]{};
+        XbitIterator<N, Block> b(buf, 0);
+        copy(first, middle, b);
+        copy(b, b + d1, copy(middle, last, first));
+        break;
+      }
+      auto mp = swap_ranges(first, middle, middle);
+      first = middle;
+      middle = mp;
+      d2 -= d1;
+    } else {
+      if (d2 <= capacity) {
+        Block buf[buffer_blocks]{};
+        XbitIterator<N, Block> b(buf, 0);
+        copy(middle, last, b);
+        copy_backward(b, b + d2, copy_backward(first, middle, last));
+        break;
+      }
+      auto mp = first + d2;
+      swap_ranges(first, mp, middle);
+      first = mp;
+      d1 -= d2;
+    }
+  }
+  return r;
+}
+
+// A block with every xbit set to x, e.g. 0b01010101 for dibit 1 in a uint8_t block.
+template <std::size_t N, std::unsigned_integral Block>
+requires tiled_xbits<N, Block>
+constexpr Block replicate(xbit_t<N> x) noexcept {
+  constexpr Block mask = XbitReference<N, Block>::mask;
+  return static_cast<Block>(std::numeric_limits<Block>::max() / mask * (x & mask));
+}
+
+// Xbits straddling blocks repeat with a period of several blocks, so the range is filled by
+// doubling: the xbits written so far are block-copied after themselves.
+template <std::size_t N, std::unsigned_integral Block>
+constexpr XbitIterator<N, Block> fill_n(
+    XbitIterator<N, Block> first, std::size_t n, xbit_t<N> x) noexcept {
+  if constexpr (tiled_xbits<N, Block>)
+    fill_bits(first.segment(), first.bit_offset(), n * N, replicate<N, Block>(x));
+  else if (n != 0) {
+    constexpr std::size_t W = block_bits<Block>;
+    Block* const p = first.segment();
+    const std::size_t off = first.bit_offset();
+    *first = x;
+    for (std::size_t done = N; done < n * N;) {
+      const std::size_t k = std::min(done, n * N - done);
+      copy_bits(p, off, p + (off + done) / W, (off + done) % W, k);
+      done += k;
+    }
+  }
+  return first + n;
+}
+
+template <std::size_t N, std::unsigned_integral Block>
+constexpr void fill(
+    XbitIterator<N, Block> first, XbitIterator<N, Block> last, xbit_t<N> x) noexcept {
+  fill_n(first, last - first, x);
+}
+
+template <std::size_t N, std::unsigned_integral Block>
+constexpr std::size_t mismatch_length(
+    const XbitIteratorBase<N, Block>& first1, std::size_t n,
+    const XbitIteratorBase<N, Block>& first2) noexcept {
+  return mismatch_bits<Block>(
+             first1.segment(), first1.bit_offset(), first2.segment(), first2.bit_offset(), n * N) /
+         N;
+}
+
+template <typename I1, typename I2>
+requires std::derived_from<I1, typename I1::Base> &&
+    std::same_as<typename I1::Base, typename I2::Base>
+constexpr std::pair<I1, I2> mismatch(I1 first1, I1 last1, I2 first2) noexcept {
+  const auto i = mismatch_length(first1, last1 - first1, first2);
+  return {first1 + i, first2 + i};
+}
+
+template <typename I1, typename I2>
+requires std::derived_from<I1, typename I1::Base> &&
+    std::same_as<typename I1::Base, typename I2::Base>
+constexpr std::pair<I1, I2> mismatch(I1 first1, I1 last1, I2 first2, I2 last2) noexcept {
+  const auto i = mismatch_length(first1, std::min(last1 - first1, last2 - first2), first2);
+  return {first1 + i, first2 + i};
+}
+
+template <std::unsigned_integral Block>
+using word_t = std::conditional_t<(block_bits<Block> < 64), std::uint64_t, Block>;
+
+// Call f(word, mask) for every word of the n bits starting at bit off of p, mask has the bits
+// belonging to the range set. Blocks narrower than 64 bits are read 64 bits at a time when the
+// blocks form a little-endian byte stream.
+template <std::unsigned_integral Block, typename F>
+constexpr void for_each_word(const Block* p, std::size_t off, std::size_t n, F f) {
+  using Word = word_t<Block>;
+  constexpr std::size_t W = block_bits<Block>;
+  if (n == 0) return;
+  if (off != 0) {
+    const std::size_t k = std::min(W - off, n);
+    f(Word{*p++}, static_cast<Word>(low_mask<Word>(k) << off));
+    n -= k;
+  }
+  if constexpr (W < 64) {
+    if (std::endian::native == std::endian::little && !std::is_constant_evaluated()) {
+      for (; n >= 64; n -= 64, p += 64 / W) {
+        Word w;
+        std::memcpy(&w, p, sizeof(w));
+        f(w, std::numeric_limits<Word>::max());
+      }
+    }
+  }
+  for (; n >= W; n -= W) f(Word{*p++}, low_mask<Word>(W));
+  if (n) f(Word{*p}, low_mask<Word>(n));
+}
+
+// OR the bits of every xbit of x into its low bit, the other bits are left unspecified.
+template <std::size_t N, std::unsigned_integral Block>
+constexpr Block fold_lanes(Block x) noexcept {
+  for (std::size_t s = 1; s < N; s *= 2) x |= static_cast<Block>(x >> s);
+  return x;
+}
+
+// The low bit of every xbit of x which is zero, e.g. 0b00'01'00'01 for 0b01'00'11'00.
+template <std::size_t N, std::unsigned_integral Block>
+constexpr Block zero_lanes(Block x) noexcept {
+  return static_cast<Block>(~fold_lanes<N>(x) & replicate<N, Block>(1));
+}
+
+// Offset of the first xbit among the n bits starting at bit off of p which equals one of the m
+// patterns, or none of them if invert is set, n if there is none. An xbit equals a pattern when it
+// is zero after XOR, so the folded lanes are ANDed over the patterns and the zero lanes are hits.
+template <std::size_t N, std::unsigned_integral Block>
+constexpr std::size_t find_lanes(
+    const Block* p, std::size_t off, std::size_t n, const word_t<Block>* patterns, std::size_t m,
+    bool invert) noexcept {
+  using Word = word_t<Block>;
+  constexpr std::size_t W = block_bits<Block>, WW = block_bits<Word>, S = WW / W;
+  constexpr Word ones = replicate<N, Word>(1);
+  const auto lanes = [=](Word w) {
+    Word a = std::numeric_limits<Word>::max();
+    for (std::size_t j = 0; j < m; ++j) a &= fold_lanes<N>(static_cast<Word>(w ^ patterns[j]));
+    return static_cast<Word>((invert ? a : ~a) & ones);
+  };
+  std::size_t i = 0;
+  if (off != 0) {
+    const std::size_t k = std::min(W - off, n);
+    const Word r = lanes(Word{*p++}) & static_cast<Word>(low_mask<Word>(k) << off);
+    if (r) return std::countr_zero(r) - off;
+    i = k;
+  }
+#if defined(__AVX2__)
+  if constexpr (WW == 64) {
+    if (!std::is_constant_evaluated()) {
+      const __m256i one = _mm256_set1_epi64x(static_cast<long long>(ones));
+      __m256i pv[1 << N];
+      for (std::size_t j = 0; j < m; ++j)
+        pv[j] = _mm256_set1_epi64x(static_cast<long long>(patterns[j]));
+      for (; n - i >= 256; i += 256, p += 256 / W) {
+        const __m256i w = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+        __m256i a = _mm256_set1_epi64x(-1);
+        for (std::size_t j = 0; j < m; ++j) {
+          __m256i x = _mm256_xor_si256(w, pv[j]);
+          for (std::size_t s = 1; s < N; s *= 2) x = _mm256_or_si256(x, _mm256_srli_epi64(x, s));
+          a = _mm256_and_si256(a, x);
+        }
+        const __m256i r = invert ? _mm256_and_si256(a, one) : _mm256_andnot_si256(a, one);
+        if (!_mm256_testz_si256(r, r)) {
+          std::uint64_t v[4];
+          _mm256_storeu_si256(reinterpret_cast<__m256i*>(v), r);
+          for (std::size_t k = 0;; ++k)
+            if (v[k]) return i + k * 64 + std::countr_zero(v[k]);
+        }
+      }
+    }
+  }
+#elif defined(__SSE2__)
+  if constexpr (WW == 64) {
+    if (!std::is_constant_evaluated()) {
+      const __m128i one = _mm_set1_epi64x(static_cast<long long>(ones));
+      __m128i pv[1 << N];
+      for (std::size_t j = 0; j < m; ++j)
+        pv[j] = _mm_set1_epi64x(static_cast<long long>(patterns[j]));
+      for (; n - i >= 128; i += 128, p += 128 / W) {
+        const __m128i w = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+        __m128i a = _mm_set1_epi64x(-1);
+        for (std::size_t j = 0; j < m; ++j) {
+          __m128i x = _mm_xor_si128(w, pv[j]);
+          for (std::size_t s = 1; s < N; s *= 2) x = _mm_or_si128(x, _mm_srli_epi64(x, s));
+          a = _mm_and_si128(a, x);
+        }
+        const __m128i r = invert ? _mm_and_si128(a, one) : _mm_andnot_si128(a, one);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi8(r, _mm_setzero_si128())) != 0xFFFF) {
+          std::uint64_t v[2];
+          _mm_storeu_si128(reinterpret_cast<__m128i*>(v), r);
+          return i + (v[0] ? std::countr_zero(v[0]) : 64 + std::countr_zero(v[1]));
+        }
+      }
+    }
+  }
+#endif
+  if (W == WW || (std::endian::native == std::endian::little && !std::is_constant_evaluated())) {
+    for (; n - i >= WW; i += WW, p += S) {
+      Word w;
+      if constexpr (W == WW) w = *p;
+      else
+        std::memcpy(&w, p, sizeof(w));
+      if (const Word r = lanes(w); r) return i + std::countr_zero(r);
+    }
+  }
+  for (; n - i >= W; i += W)
+    if (const Word r = lanes(Word{*p++}) & low_mask<Word>(W); r) return i + std::countr_zero(r);
+  if (i < n)
+    if (const Word r = lanes(Word{*p}) & low_mask<Word>(n - i); r) return i + std::countr_zero(r);
+  return n;
+}
+
+// Index of the first of the n xbits from first whose value is in set, bit x of set selects value
+// x. Whichever of the set and its complement has fewer values is compared against.
+template <std::size_t N, std::unsigned_integral Block>
+constexpr std::size_t find_first_of_length(
+    const XbitIteratorBase<N, Block>& first, std::size_t n, std::uint32_t set) noexcept {
+  using Word = word_t<Block>;
+  constexpr auto all = low_mask<std::uint32_t>(1 << N);
+  set &= all;
+  const bool invert = std::popcount(set) > (1 << N) / 2;
+  if (invert) set ^= all;
+  std::array<Word, (1 << N)> patterns{};
+  std::size_t m = 0;
+  for (std::size_t x = 0; x < patterns.size(); ++x)
+    if (set >> x & 1) patterns[m++] = replicate<N, Word>(static_cast<std::uint8_t>(x));
+  return find_lanes<N>(first.segment(), first.bit_offset(), n * N, patterns.data(), m, invert) /
+         N;
+}
+
+// The set holding x, empty when x is out of the range of std::uint8_t, e.g. 257 or -1, which as
+// for std::find matches no xbit.
+template <typename T>
+constexpr std::uint32_t symbol_set(const T& x) noexcept {
+  const auto y = static_cast<std::uint8_t>(x);
+  return y == x && y < 32 ? std::uint32_t{1} << y : 0;
+}
+
+// Whether the searches compare whole words, which takes xbits tiling the blocks and few enough
+// values for a set of them to fit in a std::uint32_t. Others are searched one xbit at a time.
+template <typename Base>
+constexpr bool word_search = false;
+
+template <std::size_t N, std::unsigned_integral Block>
+constexpr bool word_search<XbitIteratorBase<N, Block>> = tiled_xbits<N, Block> && N <= 4;
+
+template <typename I, typename T>
+requires std::derived_from<I, typename I::Base> && std::convertible_to<T, typename I::value_type>
+constexpr I find(I first, I last, const T& value) noexcept {
+  if constexpr (!word_search<typename I::Base>) return std::find(first, last, value);
+  else
+    return first + find_first_of_length(first, last - first, symbol_set(value));
+}
+
+template <typename I, typename T>
+requires std::derived_from<I, typename I::Base> && std::convertible_to<T, typename I::value_type>
+constexpr I find_not(I first, I last, const T& value) noexcept {
+  if constexpr (!word_search<typename I::Base>)
+    return std::find_if(first, last, [&](auto x) { return x != value; });
+  else
+    return first + find_first_of_length(first, last - first, ~symbol_set(value));
+}
+
+template <typename I, std::forward_iterator S>
+requires std::derived_from<I, typename I::Base> &&
+    std::convertible_to<std::iter_value_t<S>, typename I::value_type>
+constexpr I find_first_of(I first, I last, S s_first, S s_last) noexcept {
+  if constexpr (!word_search<typename I::Base>)
+    return std::find_first_of(first, last, s_first, s_last);
+  else {
+    std::uint32_t set = 0;
+    for (; s_first != s_last; ++s_first) set |= symbol_set(*s_first);
+    return first + find_first_of_length(first, last - first, set);
+  }
+}
+
+// Number of xbits equal to x among the n bits starting at bit off of p.
+template <std::size_t N, std::unsigned_integral Block>
+constexpr std::size_t count_bits(
+    const Block* p, std::size_t off, std::size_t n, xbit_t<N> x) noexcept {
+  using Word = word_t<Block>;
+  const Word pattern = replicate<N, Word>(x);
+  std::size_t r = 0;
+  for_each_word(p, off, n, [&](Word b, Word m) {
+    r += std::popcount(static_cast<Word>(zero_lanes<N>(static_cast<Word>(b ^ pattern)) & m));
+  });
+  return r;
+}
+
+// Dibits are counted from their two bit planes, other widths compare against every pattern but
+// the last one, which is what is left.
+template <std::size_t N, std::unsigned_integral Block>
+constexpr std::array<std::size_t, (1 << N)> histogram_bits(
+    const Block* p, std::size_t off, std::size_t n) noexcept {
+  std::array<std::size_t, (1 << N)> h{};
+  if constexpr (N == 2) {
+    using Word = word_t<Block>;
+    constexpr Word ones = replicate<N, Word>(1);
+    std::size_t lo = 0, hi = 0, both = 0;
+    for_each_word(p, off, n, [&](Word b, Word m) {
+      const Word l = b & ones & m;
+      const Word u = static_cast<Word>(b >> 1) & ones & m;
+      lo += std::popcount(l);
+      hi += std::popcount(u);
+      both += std::popcount(static_cast<Word>(l & u));
+    });
+    h = {n / N - lo - hi + both, lo - both, hi - both, both};
+  } else {
+    std::size_t rest = n / N;
+    for (std::size_t x = 0; x + 1 < h.size(); ++x)
+      rest -= h[x] = count_bits<N>(p, off, n, static_cast<std::uint8_t>(x));
+    h.back() = rest;
+  }
+  return h;
+}
+
+template <std::size_t N, std::unsigned_integral Block>
+constexpr std::size_t count(
+    const XbitIteratorBase<N, Block>& first, std::size_t n, xbit_t<N> x) noexcept {
+  if constexpr (tiled_xbits<N, Block>)
+    return count_bits<N>(first.segment(), first.bit_offset(), n * N, x);
+  else {
+    XbitConstIterator<N, Block> it(first.segment(), first.offset());
+    std::size_t r = 0;
+    for (; n != 0; --n, ++it) r += *it == x;
+    return r;
+  }
+}
+
+template <std::size_t N, std::unsigned_integral Block>
+requires(N <= 8) constexpr std::array<std::size_t, (1 << N)> histogram(
+    const XbitIteratorBase<N, Block>& first, std::size_t n) noexcept {
+  if constexpr (tiled_xbits<N, Block> && N <= 4)
+    return histogram_bits<N>(first.segment(), first.bit_offset(), n * N);
+  else {
+    std::array<std::size_t, (1 << N)> h{};
+    XbitConstIterator<N, Block> it(first.segment(), first.offset());
+    for (; n != 0; --n, ++it) ++h[*it];
+    return h;
+  }
+}
+
+template <typename I, typename T>
+requires std::derived_from<I, typename I::Base> && std::convertible_to<T, typename I::value_type>
+constexpr typename I::difference_type count(I first, I last, const T& value) noexcept {
+  return count(first, last - first, static_cast<typename I::value_type>(value));
+}
+
+template <typename I>
+requires std::derived_from<I, typename I::Base>
+constexpr auto histogram(I first, I last) noexcept { return histogram(first, last - first); }
+
+// A counting sort, the alphabet being at most 256 values: the histogram is taken with popcounts
+// and each value is written back as one block-level fill, O(n) instead of O(n log n) proxy swaps.
+// Like find, std::ranges::sort cannot be overloaded, call the unqualified sort(first, last).
+template <std::size_t N, std::unsigned_integral Block>
+requires(N <= 8) constexpr void sort(
+    XbitIterator<N, Block> first, XbitIterator<N, Block> last) noexcept {
+  const auto h = histogram(first, last - first);
+  for (std::size_t x = 0; x < h.size(); ++x)
+    first = fill_n(first, h[x], static_cast<xbit_t<N>>(x));
+}
+
+// Reverse the order of the xbits of a block by swapping adjacent groups of N, 2N, ... bits.
+template <std::size_t N, std::unsigned_integral Block>
+constexpr Block reverse_xbits(Block x) noexcept {
+  constexpr std::size_t W = block_bits<Block>;
+  for (std::size_t s = N; s < W; s *= 2) {
+    const Block m = static_cast<Block>(
+        std::numeric_limits<Block>::max() / low_mask<Block>(2 * s) * low_mask<Block>(s));
+    x = static_cast<Block>((x >> s & m) | (x & m) << s);
+  }
+  return x;
+}
+
+constexpr std::uint8_t reverse_complement_byte(std::uint8_t x) noexcept {
+  return static_cast<std::uint8_t>(~reverse_xbits<2>(x));
+}
+
+#if defined(__SSSE3__)
+// Reverse complement of the 4 dibits of each nibble, a byte is the two nibbles looked up and
+// swapped.
+inline __m128i reverse_complement_nibble_table() noexcept {
+  return _mm_setr_epi8(15, 11, 7, 3, 14, 10, 6, 2, 13, 9, 5, 1, 12, 8, 4, 0);
+}
+
+inline __m128i reverse_complement_epi8(__m128i x) noexcept {
+  const __m128i table = reverse_complement_nibble_table();
+  const __m128i low = _mm_set1_epi8(0x0f);
+  const __m128i lo = _mm_shuffle_epi8(table, _mm_and_si128(x, low));
+  const __m128i hi = _mm_shuffle_epi8(table, _mm_and_si128(_mm_srli_epi16(x, 4), low));
+  const __m128i r = _mm_or_si128(_mm_slli_epi16(lo, 4), hi);
+  return _mm_shuffle_epi8(r, _mm_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+}
+#endif
+
+#if defined(__AVX2__)
+inline __m256i reverse_complement_epi8(__m256i x) noexcept {
+  const __m256i table = _mm256_broadcastsi128_si256(reverse_complement_nibble_table());
+  const __m256i low = _mm256_set1_epi8(0x0f);
+  const __m256i lo = _mm256_shuffle_epi8(table, _mm256_and_si256(x, low));
+  const __m256i hi = _mm256_shuffle_epi8(table, _mm256_and_si256(_mm256_srli_epi16(x, 4), low));
+  const __m256i r = _mm256_or_si256(_mm256_slli_epi16(lo, 4), hi);
+  const __m256i reversed = _mm256_shuffle_epi8(
+      r, _mm256_setr_epi8(15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12,
+                          11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0));
+  return _mm256_permute4x64_epi64(reversed, 0x4e);
+}
+#endif
+
+// Reverse complement the dibit stream in [first, last) in place. On little-endian targets the
+// byte order is the element order whatever the block width, so blocks are handled as bytes.
+inline void reverse_complement_bytes(std::uint8_t* first, std::uint8_t* last) noexcept {
+#if defined(__AVX2__)
+  for (; last - first >= 64; first += 32) {
+    last -= 32;
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(first));
+    const __m256i b = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(last));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(first), reverse_complement_epi8(b));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(last), reverse_complement_epi8(a));
+  }
+#endif
+#if defined(__SSSE3__)
+  for (; last - first >= 32; first += 16) {
+    last -= 16;
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(first));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(last));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(first), reverse_complement_epi8(b));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(last), reverse_complement_epi8(a));
+  }
+#endif
+  for (; last - first >= 2; ++first) {
+    --last;
+    const std::uint8_t a = *first;
+    *first = reverse_complement_byte(*last);
+    *last = reverse_complement_byte(a);
+  }
+  if (first != last) *first = reverse_complement_byte(*first);
+}
+
+// Out-of-place version of the above, [first, last) and [d_first, d_first + (last - first)) must
+// not overlap.
+inline void reverse_complement_bytes(
+    const std::uint8_t* first, const std::uint8_t* last, std::uint8_t* d_first) noexcept {
+#if defined(__AVX2__)
+  for (; last - first >= 32; d_first += 32) {
+    last -= 32;
+    const __m256i a = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(last));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(d_first), reverse_complement_epi8(a));
+  }
+#endif
+#if defined(__SSSE3__)
+  for (; last - first >= 16; d_first += 16) {
+    last -= 16;
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(last));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(d_first), reverse_complement_epi8(a));
+  }
+#endif
+  while (last != first) *d_first++ = reverse_complement_byte(*--last);
+}
+
+// Reverse complement all the dibits of the blocks [first, last).
+template <std::unsigned_integral Block>
+constexpr void reverse_complement_blocks(Block* first, Block* last) noexcept {
+  if constexpr (std::endian::native == std::endian::little) {
+    if (!std::is_constant_evaluated()) {
+      reverse_complement_bytes(
+          reinterpret_cast<std::uint8_t*>(first), reinterpret_cast<std::uint8_t*>(last));
+      return;
+    }
+  }
+  for (; last - first >= 2; ++first) {
+    --last;
+    const Block a = *first;
+    *first = static_cast<Block>(~reverse_xbits<2>(*last));
+    *last = static_cast<Block>(~reverse_xbits<2>(a));
+  }
+  if (first != last) *first = static_cast<Block>(~reverse_xbits<2>(*first));
+}
+
+// Reverse complement the dibits of [first, last) in place. The covering blocks are reversed as a
+// whole, the range is then shifted back to its position and the bits outside of it restored.
+template <std::unsigned_integral Block>
+constexpr void reverse_complement(
+    XbitIterator<2, Block> first, XbitIterator<2, Block> last) noexcept {
+  constexpr std::size_t xbits_per_block = XbitIterator<2, Block>::xbits_per_block;
+  if (last - first < 2) {
+    if (first != last) *first = static_cast<std::uint8_t>(~*first);
+    return;
+  }
+  Block* const seg = first.segment();
+  Block* const seg_end = last.segment() + (last.offset() != 0);
+  const std::size_t n = last - first;
+  const std::size_t head = first.offset();
+  const std::size_t tail = (seg_end - seg) * xbits_per_block - head - n;
+  const Block front = *seg;
+  const Block back = seg_end[-1];
+  reverse_complement_blocks(seg, seg_end);
+  if (tail > head) copy(first + (tail - head), last + (tail - head), first);
+  else if (head > tail)
+    copy_backward(first - (head - tail), last - (head - tail), last);
+  if (head != 0) {
+    const Block m = low_mask<Block>(head * 2);
+    *seg = static_cast<Block>((*seg & ~m) | (front & m));
+  }
+  if (tail != 0) {
+    const Block m = static_cast<Block>(~low_mask<Block>((xbits_per_block - tail) * 2));
+    seg_end[-1] = static_cast<Block>((seg_end[-1] & ~m) | (back & m));
+  }
+}
+
+// Write the reverse complement of [first, last) to d_first, the ranges must not overlap. Whole
+// bytes go straight through the SIMD kernel when the source ends and the destination starts on a
+// byte, otherwise the range is block-copied and reversed in place.
+template <std::unsigned_integral Block>
+constexpr XbitIterator<2, Block> reverse_complement_copy(
+    XbitConstIterator<2, Block> first, XbitConstIterator<2, Block> last,
+    XbitIterator<2, Block> d_first) noexcept {
+  constexpr std::size_t per_byte = CHAR_BIT / 2;
+  if (std::is_constant_evaluated()) {
+    while (last != first) *d_first++ = static_cast<std::uint8_t>(~*--last);
+    return d_first;
+  }
+  if (std::endian::native == std::endian::little && last.offset() % per_byte == 0 &&
+      d_first.offset() % per_byte == 0) {
+    const std::size_t bytes = (last - first) / per_byte;
+    const auto* src =
+        reinterpret_cast<const std::uint8_t*>(last.segment()) + last.offset() / per_byte;
+    auto* dst = reinterpret_cast<std::uint8_t*>(d_first.segment()) + d_first.offset() / per_byte;
+    reverse_complement_bytes(src - bytes, src, dst);
+    d_first += bytes * per_byte;
+    last -= bytes * per_byte;
+    while (last != first) *d_first++ = static_cast<std::uint8_t>(~*--last);
+    return d_first;
+  }
+  const auto d_last = copy(first, last, d_first);
+  reverse_complement(d_first, d_last);
+  return d_last;
+}
+
+template <std::unsigned_integral Block>
+constexpr XbitIterator<2, Block> reverse_complement_copy(
+    XbitIterator<2, Block> first, XbitIterator<2, Block> last,
+    XbitIterator<2, Block> d_first) noexcept {
+  return reverse_complement_copy(
+      XbitConstIterator<2, Block>(first), XbitConstIterator<2, Block>(last), d_first);
+}
+
+// The blocks an XbitVector keeps within itself, an empty class when there are none.
+template <typename Block, std::size_t N>
+struct InlineStorage {
+  Block blocks[N]{};
+
+  constexpr Block* data() noexcept { return blocks; }
+
+  constexpr const Block* data() const noexcept { return blocks; }
+};
+
+template <typename Block>
+struct InlineStorage<Block, 0> {
+  constexpr Block* data() noexcept { return nullptr; }
+
+  constexpr const Block* data() const noexcept { return nullptr; }
+};
+
 class XbitVectorBase {
  protected:
   constexpr XbitVectorBase() = default;
@@ -280,10 +1289,16 @@ class XbitVectorBase {
   }
 };
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-requires(!std::same_as<Block, bool>) class XbitVector : private detail::XbitVectorBase {
+template <std::size_t N, typename Block>
+requires std::unsigned_integral<std::remove_const_t<Block>> class XbitSpan;
+
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks = 0>
+requires(!std::same_as<Block, bool> && N >= 1 && N <= 16) class XbitVector
+    : private detail::XbitVectorBase {
  public:
-  typedef std::uint8_t value_type;
+  typedef xbit_t<N> value_type;
   typedef Block block_type;
   typedef std::size_t size_type;
   typedef std::ptrdiff_t difference_type;
@@ -301,10 +1316,13 @@ requires(!std::same_as<Block, bool>) class XbitVector : private detail::XbitVect
   constexpr static std::size_t xbits_per_block = iterator::xbits_per_block;
 
  private:
-  block_type* begin_{};
+  block_type* begin_ = inline_data();
   size_type size_{};
-  size_type cap_{};
-  /*[[no_unique_address]]*/ allocator_type alloc_{};
+  size_type cap_ = InlineBlocks;
+  // Stateless allocators take no space, sizeof is three words.
+  [[no_unique_address]] allocator_type alloc_{};
+  // Up to InlineBlocks blocks are kept here rather than on the heap, begin_ then points here.
+  [[no_unique_address]] detail::InlineStorage<block_type, InlineBlocks> inline_{};
 
  public:
   constexpr XbitVector() noexcept(std::is_nothrow_default_constructible_v<allocator_type>);
@@ -424,6 +1442,41 @@ requires(!std::same_as<Block, bool>) class XbitVector : private detail::XbitVect
 
   constexpr const block_type* data() const noexcept { return begin_; }
 
+  // The count xbits from pos as one integer, the one at pos in the lowest bits. They are read
+  // from the blocks holding them in one go, 0 < count <= 64 / N.
+  constexpr std::uint64_t get_bits(size_type pos, size_type count) const noexcept {
+    assert(0 < count && count * N <= 64 && pos + count <= size());
+    if (unchecked_word_access(pos))
+      return detail::load_bits64_unchecked(
+          reinterpret_cast<const unsigned char*>(data()), pos * N, count * N);
+    return detail::load_bits64(data(), pos * N, count * N);
+  }
+
+  // Overwrite the count xbits from pos with the low count * N bits of value.
+  constexpr void set_bits(size_type pos, size_type count, std::uint64_t value) noexcept {
+    assert(0 < count && count * N <= 64 && pos + count <= size());
+    if (unchecked_word_access(pos))
+      detail::store_bits64_unchecked(
+          reinterpret_cast<unsigned char*>(data()), pos * N, count * N, value);
+    else
+      detail::store_bits64(data(), pos * N, count * N, value);
+  }
+
+  // The len xbits from pos, or all of them up to the end, as a new vector. Like the other
+  // block-level algorithms the bits are moved a block at a time, with one shift and or per block
+  // when pos is not on a block boundary. Throws std::out_of_range when pos > size().
+  constexpr XbitVector substr(size_type pos = 0, size_type len = std::dynamic_extent) const;
+
+  // Append the len xbits of v from pos, or all of them up to the end, v may be *this. Throws
+  // std::out_of_range when pos > v.size().
+  constexpr XbitVector& append(
+      const XbitVector& v, size_type pos = 0, size_type len = std::dynamic_extent);
+
+  constexpr XbitVector& append(XbitSpan<N, const block_type> s) {
+    append_xbits(s.begin(), s.size());
+    return *this;
+  }
+
   constexpr void push_back(const value_type& x);
 
   template <typename... Args>
@@ -463,16 +1516,49 @@ requires(!std::same_as<Block, bool>) class XbitVector : private detail::XbitVect
 
   constexpr void resize(size_type sz, value_type x = 0);
 
+  // As resize, but the xbits past the old size are left unspecified for the caller to overwrite.
+  constexpr void resize_for_overwrite(size_type sz);
+
   constexpr void flip() noexcept;
 
-  constexpr bool operator==(const XbitVector& other) const {
-    return size() == other.size() && std::equal(begin(), end(), other.begin());
+  constexpr size_type count(value_type x) const noexcept {
+    return detail::count(begin(), size(), x);
   }
 
-  constexpr auto operator<=>(const XbitVector& other) const {
-    return std::lexicographical_compare_three_way(begin(), end(), other.begin(), other.end());
+  constexpr std::array<size_type, (1 << N)> histogram() const noexcept requires(N <= 8) {
+    return detail::histogram(begin(), size());
+  }
+
+  constexpr iterator find(value_type x) noexcept { return detail::find(begin(), end(), x); }
+
+  constexpr const_iterator find(value_type x) const noexcept {
+    return detail::find(begin(), end(), x);
   }
 
+  constexpr iterator find_not(value_type x) noexcept { return detail::find_not(begin(), end(), x); }
+
+  constexpr const_iterator find_not(value_type x) const noexcept {
+    return detail::find_not(begin(), end(), x);
+  }
+
+  constexpr iterator find_first_of(std::initializer_list<value_type> il) noexcept {
+    return detail::find_first_of(begin(), end(), il.begin(), il.end());
+  }
+
+  constexpr const_iterator find_first_of(std::initializer_list<value_type> il) const noexcept {
+    return detail::find_first_of(begin(), end(), il.begin(), il.end());
+  }
+
+  constexpr void reverse_complement() noexcept requires(N == 2) {
+    detail::reverse_complement(begin(), end());
+  }
+
+  constexpr void reverse_complement(XbitVector& out) const requires(N == 2);
+
+  constexpr bool operator==(const XbitVector& other) const noexcept;
+
+  constexpr std::strong_ordering operator<=>(const XbitVector& other) const noexcept;
+
  private:
   constexpr bool invariants() const;
 
@@ -482,16 +1568,43 @@ requires(!std::same_as<Block, bool>) class XbitVector : private detail::XbitVect
 
   constexpr void vdeallocate() noexcept;
 
+  constexpr block_type* inline_data() noexcept { return inline_.data(); }
+
+  constexpr bool is_inline() const noexcept {
+    return InlineBlocks != 0 && begin_ == inline_.data();
+  }
+
+  constexpr void steal(XbitVector& v) noexcept;
+
+  constexpr static bool tiled = iterator::tiled;
+
+  // Whether the 9 bytes from the one holding xbit pos are within the allocated blocks, so that
+  // narrow blocks can be accessed as a little-endian word. 64-bit blocks are accessed as such.
+  constexpr bool unchecked_word_access(size_type pos) const noexcept {
+    if constexpr (block_bits<block_type> < 64 && std::endian::native == std::endian::little)
+      return !std::is_constant_evaluated() &&
+             pos * N / CHAR_BIT + 9 <= this->cap_ * sizeof(block_type);
+    else
+      return false;
+  }
+
   constexpr static size_type internal_cap_to_external(size_type n) noexcept {
-    return n * xbits_per_block;
+    if constexpr (tiled) return n * xbits_per_block;
+    else
+      return n * block_bits<block_type> / N;
   }
 
   constexpr static size_type external_cap_to_internal(size_type n) noexcept {
-    return (n - 1) / xbits_per_block + 1;
+    if constexpr (tiled) return (n - 1) / xbits_per_block + 1;
+    else
+      return (n * N - 1) / block_bits<block_type> + 1;
   }
 
   constexpr static size_type align_it(size_type new_size) noexcept {
-    return (new_size + (xbits_per_block - 1)) / xbits_per_block * xbits_per_block;
+    if constexpr (tiled)
+      return (new_size + (xbits_per_block - 1)) / xbits_per_block * xbits_per_block;
+    else
+      return internal_cap_to_external(external_cap_to_internal(new_size));
   }
 
   constexpr size_type recommend(size_type new_size) const;
@@ -501,12 +1614,17 @@ requires(!std::same_as<Block, bool>) class XbitVector : private detail::XbitVect
   constexpr void construct_at_end(
       std::forward_iterator auto first, std::forward_iterator auto last);
 
+  constexpr void append_xbits(const_iterator first, size_type n);
+
   constexpr iterator make_iter(size_type pos) noexcept {
-    return iterator(begin_ + pos / xbits_per_block, pos & (xbits_per_block - 1));
+    if constexpr (tiled)
+      return iterator(begin_ + pos / xbits_per_block, pos & (xbits_per_block - 1));
+    else
+      return iterator(begin_ + pos * N / block_bits<block_type>, pos * N % block_bits<block_type>);
   }
 
   constexpr const_iterator make_iter(size_type pos) const noexcept {
-    return const_iterator(begin_ + pos / xbits_per_block, pos & (xbits_per_block - 1));
+    return const_cast<XbitVector*>(this)->make_iter(pos);
   }
 
   constexpr iterator const_iterator_cast(const_iterator p) noexcept {
@@ -531,40 +1649,79 @@ requires(!std::same_as<Block, bool>) class XbitVector : private detail::XbitVect
   }
 };
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr void XbitVector<N, Block, Allocator>::invalidate_all_iterators() {}
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::invalidate_all_iterators() {}
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr void XbitVector<N, Block, Allocator>::vallocate(size_type n) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::vallocate(size_type n) {
   if (n > max_size()) this->throw_length_error();
   n = external_cap_to_internal(n);
-  this->begin_ = allocator_traits::allocate(this->alloc_, n);
+  if (n <= InlineBlocks) {
+    this->begin_ = inline_data();
+    n = InlineBlocks;
+  } else
+    this->begin_ = allocator_traits::allocate(this->alloc_, n);
   this->size_ = 0;
   this->cap_ = n;
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr void XbitVector<N, Block, Allocator>::vdeallocate() noexcept {
-  if (this->begin_ != nullptr) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::vdeallocate() noexcept {
+  if (this->begin_ != nullptr && !is_inline()) {
     allocator_traits::deallocate(this->alloc_, this->begin_, this->cap_);
     invalidate_all_iterators();
-    this->begin_ = nullptr;
-    this->size_ = this->cap_ = 0;
+    this->begin_ = inline_data();
+    this->size_ = 0;
+    this->cap_ = InlineBlocks;
+  }
+}
+
+// Take over the blocks of v and leave it empty, inline blocks have to be copied.
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::steal(XbitVector& v) noexcept {
+  if (v.is_inline()) {
+    std::copy_n(v.inline_.data(), InlineBlocks, inline_.data());
+    this->begin_ = inline_data();
+    this->cap_ = InlineBlocks;
+  } else {
+    this->begin_ = v.begin_;
+    this->cap_ = v.cap_;
   }
+  this->size_ = v.size_;
+  v.begin_ = v.inline_data();
+  v.size_ = 0;
+  v.cap_ = InlineBlocks;
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::size_type XbitVector<N, Block, Allocator>::max_size()
-    const noexcept {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::size_type
+XbitVector<N, Block, Allocator, InlineBlocks>::max_size() const noexcept {
   size_type amax = allocator_traits::max_size(alloc_);
   size_type nmax = std::numeric_limits<size_type>::max() / 2;
-  if (nmax / xbits_per_block <= amax) return nmax;
+  if constexpr (!tiled) {
+    // Dense xbits are addressed in bits, which must not overflow.
+    nmax /= N;
+    if (external_cap_to_internal(nmax) <= amax) return nmax;
+  } else if (nmax / xbits_per_block <= amax)
+    return nmax;
   return internal_cap_to_external(amax);
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::size_type XbitVector<N, Block, Allocator>::recommend(
-    size_type new_size) const {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::size_type
+XbitVector<N, Block, Allocator, InlineBlocks>::recommend(size_type new_size) const {
   const size_type ms = max_size();
   if (new_size > ms) this->throw_length_error();
   const size_type cap = capacity();
@@ -572,91 +1729,138 @@ constexpr XbitVector<N, Block, Allocator>::size_type XbitVector<N, Block, Alloca
   return std::max(2 * cap, align_it(new_size));
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr void XbitVector<N, Block, Allocator>::construct_at_end(size_type n, value_type x) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::construct_at_end(
+    size_type n, value_type x) {
   size_type old_size = this->size_;
   this->size_ += n;
-  std::fill_n(make_iter(old_size), n, x);
+  fill_n(make_iter(old_size), n, x);
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr void XbitVector<N, Block, Allocator>::construct_at_end(
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::construct_at_end(
     std::forward_iterator auto first, std::forward_iterator auto last) {
   size_type old_size = this->size_;
   this->size_ += std::distance(first, last);
-  std::copy(first, last, make_iter(old_size));
+  using std::copy;
+  copy(first, last, make_iter(old_size));
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::XbitVector() noexcept(
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::append_xbits(
+    const_iterator first, size_type n) {
+  const size_type old_size = this->size_;
+  if (n <= capacity() - old_size) {
+    this->size_ += n;
+    copy(first, first + n, make_iter(old_size));
+  } else {
+    // first may point into the old blocks, which stay alive until the swap.
+    XbitVector v(alloc_);
+    v.reserve(recommend(old_size + n));
+    v.size_ = old_size + n;
+    copy(cbegin(), cend(), v.begin());
+    copy(first, first + n, v.make_iter(old_size));
+    swap(v);
+  }
+}
+
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::XbitVector() noexcept(
     std::is_nothrow_default_constructible_v<allocator_type>) {}
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::XbitVector(const allocator_type& a) noexcept
-    : cap_(0), alloc_(a) {}
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::XbitVector(
+    const allocator_type& a) noexcept
+    : alloc_(a) {}
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::XbitVector(size_type n) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::XbitVector(size_type n) {
   if (n > 0) {
     vallocate(n);
     construct_at_end(n, 0);
   }
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::XbitVector(size_type n, const allocator_type& a)
-    : cap_(0), alloc_(a) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::XbitVector(
+    size_type n, const allocator_type& a)
+    : alloc_(a) {
   if (n > 0) {
     vallocate(n);
     construct_at_end(n, 0);
   }
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::XbitVector(size_type n, const value_type& x) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::XbitVector(
+    size_type n, const value_type& x) {
   if (n > 0) {
     vallocate(n);
     construct_at_end(n, x);
   }
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::XbitVector(
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::XbitVector(
     size_type n, const value_type& x, const allocator_type& a)
-    : cap_(0), alloc_(a) {
+    : alloc_(a) {
   if (n > 0) {
     vallocate(n);
     construct_at_end(n, x);
   }
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::XbitVector(
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::XbitVector(
     std::input_iterator auto first, std::input_iterator auto last) {
   try {
     for (; first != last; ++first) push_back(*first);
   } catch (...) {
-    if (begin_ != nullptr) allocator_traits::deallocate(alloc_, begin_, cap_);
+    vdeallocate();
     invalidate_all_iterators();
     throw;
   }
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::XbitVector(
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::XbitVector(
     std::input_iterator auto first, std::input_iterator auto last, const allocator_type& a)
-    : cap_(0), alloc_(a) {
+    : alloc_(a) {
   try {
     for (; first != last; ++first) push_back(*first);
   } catch (...) {
-    if (begin_ != nullptr) allocator_traits::deallocate(alloc_, begin_, cap_);
+    vdeallocate();
     invalidate_all_iterators();
     throw;
   }
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::XbitVector(
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::XbitVector(
     std::forward_iterator auto first, std::forward_iterator auto last) {
   const size_type n = std::distance(first, last);
   if (n > 0) {
@@ -665,10 +1869,12 @@ constexpr XbitVector<N, Block, Allocator>::XbitVector(
   }
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::XbitVector(
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::XbitVector(
     std::forward_iterator auto first, std::forward_iterator auto last, const allocator_type& a)
-    : cap_(0), alloc_(a) {
+    : alloc_(a) {
   const size_type n = std::distance(first, last);
   if (n > 0) {
     vallocate(n);
@@ -676,8 +1882,11 @@ constexpr XbitVector<N, Block, Allocator>::XbitVector(
   }
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::XbitVector(std::initializer_list<value_type> il) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::XbitVector(
+    std::initializer_list<value_type> il) {
   const size_type n = il.size();
   if (n > 0) {
     vallocate(n);
@@ -685,10 +1894,12 @@ constexpr XbitVector<N, Block, Allocator>::XbitVector(std::initializer_list<valu
   }
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::XbitVector(
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::XbitVector(
     std::initializer_list<value_type> il, const allocator_type& a)
-    : cap_(0), alloc_(a) {
+    : alloc_(a) {
   const size_type n = il.size();
   if (n > 0) {
     vallocate(n);
@@ -696,33 +1907,42 @@ constexpr XbitVector<N, Block, Allocator>::XbitVector(
   }
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::~XbitVector() {
-  if (begin_ != nullptr) allocator_traits::deallocate(alloc_, begin_, cap_);
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::~XbitVector() {
+  vdeallocate();
   invalidate_all_iterators();
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::XbitVector(const XbitVector& v)
-    : cap_(0), alloc_(allocator_traits::select_on_container_copy_construction(v.alloc_)) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::XbitVector(const XbitVector& v)
+    : alloc_(allocator_traits::select_on_container_copy_construction(v.alloc_)) {
   if (v.size() > 0) {
     vallocate(v.size());
     construct_at_end(v.begin(), v.end());
   }
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::XbitVector(const XbitVector& v, const allocator_type& a)
-    : cap_(0), alloc_(a) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::XbitVector(
+    const XbitVector& v, const allocator_type& a)
+    : alloc_(a) {
   if (v.size() > 0) {
     vallocate(v.size());
     construct_at_end(v.begin(), v.end());
   }
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>& XbitVector<N, Block, Allocator>::operator=(
-    const XbitVector& v) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>&
+XbitVector<N, Block, Allocator, InlineBlocks>::operator=(const XbitVector& v) {
   if (this != &v) {
     copy_assign_alloc(v);
     if (v.size_) {
@@ -737,32 +1957,32 @@ constexpr XbitVector<N, Block, Allocator>& XbitVector<N, Block, Allocator>::oper
   return *this;
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::XbitVector(XbitVector&& v) noexcept
-    : begin_(v.begin_), size_(v.size_), cap_(v.cap_), alloc_(v.alloc_) {
-  v.begin_ = nullptr;
-  v.size_ = 0;
-  v.cap_ = 0;
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::XbitVector(XbitVector&& v) noexcept
+    : alloc_(std::move(v.alloc_)) {
+  steal(v);
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::XbitVector(XbitVector&& v, const allocator_type& a)
-    : cap_(0), alloc_(a) {
-  if (a == allocator_type(v.alloc_)) {
-    this->begin_ = v.begin_;
-    this->size_ = v.size_;
-    this->cap_ = v.cap_;
-    v.begin_ = nullptr;
-    v.cap_ = v.size_ = 0;
-  } else if (v.size() > 0) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::XbitVector(
+    XbitVector&& v, const allocator_type& a)
+    : alloc_(a) {
+  if (a == allocator_type(v.alloc_)) steal(v);
+  else if (v.size() > 0) {
     vallocate(v.size());
     construct_at_end(v.begin(), v.end());
   }
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>&
-XbitVector<N, Block, Allocator>::operator=(XbitVector&& v) noexcept(
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>&
+XbitVector<N, Block, Allocator, InlineBlocks>::operator=(XbitVector&& v) noexcept(
     allocator_traits::propagate_on_container_move_assignment::value ||
     allocator_traits::is_always_equal::value) {
   if constexpr (allocator_traits::propagate_on_container_move_assignment::value) move_assign(v);
@@ -774,20 +1994,21 @@ XbitVector<N, Block, Allocator>::operator=(XbitVector&& v) noexcept(
   return *this;
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr void XbitVector<N, Block, Allocator>::move_assign(XbitVector& c) noexcept(
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::move_assign(XbitVector& c) noexcept(
     std::is_nothrow_move_assignable_v<allocator_type>) {
   vdeallocate();
   move_assign_alloc(c);
-  this->begin_ = c.begin_;
-  this->size_ = c.size_;
-  this->cap_ = c.cap_;
-  c.begin_ = nullptr;
-  c.cap_ = c.size_ = 0;
+  steal(c);
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr void XbitVector<N, Block, Allocator>::assign(size_type n, const value_type& x) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::assign(
+    size_type n, const value_type& x) {
   size_ = 0;
   if (n > 0) {
     size_type c = capacity();
@@ -798,20 +2019,24 @@ constexpr void XbitVector<N, Block, Allocator>::assign(size_type n, const value_
       v.size_ = n;
       swap(v);
     }
-    std::fill_n(begin(), n, x);
+    fill_n(begin(), n, x);
   }
   invalidate_all_iterators();
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr void XbitVector<N, Block, Allocator>::assign(
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::assign(
     std::input_iterator auto first, std::input_iterator auto last) {
   clear();
   for (; first != last; ++first) push_back(*first);
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr void XbitVector<N, Block, Allocator>::assign(
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::assign(
     std::forward_iterator auto first, std::forward_iterator auto last) {
   clear();
   difference_type ns = std::distance(first, last);
@@ -826,8 +2051,10 @@ constexpr void XbitVector<N, Block, Allocator>::assign(
   }
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr void XbitVector<N, Block, Allocator>::reserve(size_type n) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::reserve(size_type n) {
   if (n > capacity()) {
     XbitVector v(this->alloc_);
     v.vallocate(n);
@@ -837,82 +2064,120 @@ constexpr void XbitVector<N, Block, Allocator>::reserve(size_type n) {
   }
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr void XbitVector<N, Block, Allocator>::shrink_to_fit() noexcept {
-  if (external_cap_to_internal(size()) > cap_) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::shrink_to_fit() noexcept {
+  if (num_blocks() < cap_ && cap_ > InlineBlocks) {
     try {
       XbitVector(*this, allocator_type(alloc_)).swap(*this);
     } catch (...) {}
   }
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::reference XbitVector<N, Block, Allocator>::at(
-    size_type n) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::reference
+XbitVector<N, Block, Allocator, InlineBlocks>::at(size_type n) {
   if (n >= size()) this->throw_out_of_range();
   return (*this)[n];
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::const_reference XbitVector<N, Block, Allocator>::at(
-    size_type n) const {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::const_reference
+XbitVector<N, Block, Allocator, InlineBlocks>::at(size_type n) const {
   if (n >= size()) this->throw_out_of_range();
   return (*this)[n];
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr void XbitVector<N, Block, Allocator>::push_back(const value_type& x) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>
+XbitVector<N, Block, Allocator, InlineBlocks>::substr(size_type pos, size_type len) const {
+  if (pos > size()) this->throw_out_of_range();
+  XbitVector r(allocator_traits::select_on_container_copy_construction(alloc_));
+  r.append_xbits(make_iter(pos), std::min(len, size() - pos));
+  return r;
+}
+
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>&
+XbitVector<N, Block, Allocator, InlineBlocks>::append(
+    const XbitVector& v, size_type pos, size_type len) {
+  if (pos > v.size()) this->throw_out_of_range();
+  append_xbits(v.make_iter(pos), std::min(len, v.size() - pos));
+  return *this;
+}
+
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::push_back(const value_type& x) {
   if (this->size_ == this->capacity()) reserve(recommend(this->size_ + 1));
   ++this->size_;
   back() = x;
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::iterator XbitVector<N, Block, Allocator>::insert(
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::iterator
+XbitVector<N, Block, Allocator, InlineBlocks>::insert(
     const_iterator position, const value_type& x) {
   iterator r;
   if (size() < capacity()) {
     const_iterator old_end = end();
     ++size_;
-    std::copy_backward(position, old_end, end());
+    copy_backward(position, old_end, end());
     r = const_iterator_cast(position);
   } else {
     XbitVector v(alloc_);
     v.reserve(recommend(size_ + 1));
     v.size_ = size_ + 1;
-    r = std::copy(cbegin(), position, v.begin());
-    std::copy_backward(position, cend(), v.end());
+    r = copy(cbegin(), position, v.begin());
+    copy_backward(position, cend(), v.end());
     swap(v);
   }
   *r = x;
   return r;
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::iterator XbitVector<N, Block, Allocator>::insert(
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::iterator
+XbitVector<N, Block, Allocator, InlineBlocks>::insert(
     const_iterator position, size_type n, const value_type& x) {
   iterator r;
   size_type c = capacity();
   if (n <= c && size() <= c - n) {
     const_iterator old_end = end();
     size_ += n;
-    std::copy_backward(position, old_end, end());
+    copy_backward(position, old_end, end());
     r = const_iterator_cast(position);
   } else {
     XbitVector v(alloc_);
     v.reserve(recommend(size_ + n));
     v.size_ = size_ + n;
-    r = std::copy(cbegin(), position, v.begin());
-    std::copy_backward(position, cend(), v.end());
+    r = copy(cbegin(), position, v.begin());
+    copy_backward(position, cend(), v.end());
     swap(v);
   }
-  std::fill_n(r, n, x);
+  fill_n(r, n, x);
   return r;
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr typename XbitVector<N, Block, Allocator>::iterator
-XbitVector<N, Block, Allocator>::insert(
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr typename XbitVector<N, Block, Allocator, InlineBlocks>::iterator
+XbitVector<N, Block, Allocator, InlineBlocks>::insert(
     const_iterator position, std::input_iterator auto first, std::input_iterator auto last) {
   difference_type off = position - begin();
   iterator p = const_iterator_cast(position);
@@ -935,13 +2200,16 @@ XbitVector<N, Block, Allocator>::insert(
       throw;
     }
   }
-  p = std::rotate(p, old_end, end());
+  p = rotate(p, old_end, end());
   insert(p, v.begin(), v.end());
   return begin() + off;
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::iterator XbitVector<N, Block, Allocator>::insert(
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::iterator
+XbitVector<N, Block, Allocator, InlineBlocks>::insert(
     const_iterator position, std::forward_iterator auto first, std::forward_iterator auto last) {
   const difference_type n_signed = std::distance(first, last);
   assert(n_signed >= 0 && "invalid range specified");
@@ -951,50 +2219,69 @@ constexpr XbitVector<N, Block, Allocator>::iterator XbitVector<N, Block, Allocat
   if (n <= c && size() <= c - n) {
     const_iterator old_end = end();
     size_ += n;
-    std::copy_backward(position, old_end, end());
+    copy_backward(position, old_end, end());
     r = const_iterator_cast(position);
   } else {
     XbitVector v(alloc_);
     v.reserve(recommend(size_ + n));
     v.size_ = size_ + n;
-    r = std::copy(cbegin(), position, v.begin());
-    std::copy_backward(position, cend(), v.end());
+    r = copy(cbegin(), position, v.begin());
+    copy_backward(position, cend(), v.end());
     swap(v);
   }
-  std::copy(first, last, r);
+  using std::copy;
+  copy(first, last, r);
   return r;
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::iterator XbitVector<N, Block, Allocator>::erase(
-    const_iterator position) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::iterator
+XbitVector<N, Block, Allocator, InlineBlocks>::erase(const_iterator position) {
   iterator r = const_iterator_cast(position);
-  std::copy(position + 1, this->cend(), r);
+  copy(position + 1, this->cend(), r);
   --size_;
   return r;
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr XbitVector<N, Block, Allocator>::iterator XbitVector<N, Block, Allocator>::erase(
-    const_iterator first, const_iterator last) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr XbitVector<N, Block, Allocator, InlineBlocks>::iterator
+XbitVector<N, Block, Allocator, InlineBlocks>::erase(const_iterator first, const_iterator last) {
   iterator r = const_iterator_cast(first);
   difference_type d = last - first;
-  std::copy(last, this->cend(), r);
+  copy(last, this->cend(), r);
   size_ -= d;
   return r;
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr void XbitVector<N, Block, Allocator>::swap(XbitVector& x) noexcept {
-  std::swap(this->begin_, x.begin_);
-  std::swap(this->size_, x.size_);
-  std::swap(this->cap_, x.cap_);
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::swap(XbitVector& x) noexcept {
+  // Without propagation the blocks can only change hands between equal allocators.
+  assert(allocator_traits::propagate_on_container_swap::value || alloc_ == x.alloc_);
+  if (is_inline() || x.is_inline()) {
+    // Inline blocks cannot change hands, they are copied through a third vector.
+    XbitVector t(alloc_);
+    t.steal(x);
+    x.steal(*this);
+    steal(t);
+  } else {
+    std::swap(this->begin_, x.begin_);
+    std::swap(this->size_, x.size_);
+    std::swap(this->cap_, x.cap_);
+  }
   if constexpr (allocator_traits::propagate_on_container_swap::value)
     std::swap(this->alloc_, x.alloc_);
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr void XbitVector<N, Block, Allocator>::resize(size_type sz, value_type x) {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::resize(size_type sz, value_type x) {
   size_type cs = size();
   if (cs < sz) {
     iterator r;
@@ -1007,22 +2294,82 @@ constexpr void XbitVector<N, Block, Allocator>::resize(size_type sz, value_type
       XbitVector v(alloc_);
       v.reserve(recommend(size_ + n));
       v.size_ = size_ + n;
-      r = std::copy(cbegin(), cend(), v.begin());
+      r = copy(cbegin(), cend(), v.begin());
       swap(v);
     }
-    std::fill_n(r, n, x);
+    fill_n(r, n, x);
   } else
     size_ = sz;
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr void XbitVector<N, Block, Allocator>::flip() noexcept {
-  size_type n = 0;
-  for (block_type* p = begin_; n < size_; ++p, n += xbits_per_block) *p = ~*p;
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::resize_for_overwrite(
+    size_type sz) {
+  if (sz > capacity()) {
+    XbitVector v(alloc_);
+    v.reserve(recommend(sz));
+    v.size_ = size_;
+    copy(cbegin(), cend(), v.begin());
+    swap(v);
+  }
+  size_ = sz;
 }
 
-template <std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator>
-constexpr bool XbitVector<N, Block, Allocator>::invariants() const {
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::flip() noexcept {
+  // Bounded by a local end, narrow block stores would otherwise reload size_ on every step.
+  for (block_type *p = begin_, *last = begin_ + num_blocks(); p != last; ++p)
+    *p = static_cast<block_type>(~*p);
+}
+
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr void XbitVector<N, Block, Allocator, InlineBlocks>::reverse_complement(
+    XbitVector& out) const requires(N == 2) {
+  if (this == &out) {
+    out.reverse_complement();
+    return;
+  }
+  if (size_ > out.capacity()) {
+    out.vdeallocate();
+    out.vallocate(size_);
+  }
+  out.size_ = size_;
+  reverse_complement_copy(cbegin(), cend(), out.begin());
+}
+
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr bool XbitVector<N, Block, Allocator, InlineBlocks>::operator==(
+    const XbitVector& other) const noexcept {
+  if (size() != other.size()) return false;
+  const size_type nb = size() * N / block_bits<block_type>;
+  if (!std::equal(begin_, begin_ + nb, other.begin_)) return false;
+  const size_type rest = size() * N % block_bits<block_type>;
+  return rest == 0 || ((begin_[nb] ^ other.begin_[nb]) & low_mask<block_type>(rest)) == 0;
+}
+
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr std::strong_ordering XbitVector<N, Block, Allocator, InlineBlocks>::operator<=>(
+    const XbitVector& other) const noexcept {
+  const size_type n = std::min(size(), other.size());
+  const size_type i = mismatch_length(begin(), n, other.begin());
+  if (i != n) return (*this)[i] <=> other[i];
+  return size() <=> other.size();
+}
+
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr bool XbitVector<N, Block, Allocator, InlineBlocks>::invariants() const {
   if (this->begin_ == nullptr) {
     if (this->size_ != 0 || this->cap_ != 0) return false;
   } else {
@@ -1032,8 +2379,216 @@ constexpr bool XbitVector<N, Block, Allocator>::invariants() const {
   return true;
 }
 
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+constexpr auto mismatch(
+    const XbitVector<N, Block, Allocator, InlineBlocks>& a,
+    const XbitVector<N, Block, Allocator, InlineBlocks>& b) noexcept {
+  return mismatch(a.begin(), a.end(), b.begin(), b.end());
+}
+
+template <
+    std::size_t N, std::unsigned_integral Block, std::copy_constructible Allocator,
+    std::size_t InlineBlocks>
+requires(N <= 8) constexpr void sort(XbitVector<N, Block, Allocator, InlineBlocks>& v) noexcept {
+  sort(v.begin(), v.end());
+}
+
+// A non-owning view of size() xbits which may start at any xbit of a block buffer, read-only
+// when Block is const like std::span. It shares the iterators, and so the block-level
+// algorithms, of XbitVector, which converts to it implicitly.
+template <std::size_t N, typename Block>
+requires std::unsigned_integral<std::remove_const_t<Block>> class XbitSpan {
+ public:
+  typedef xbit_t<N> value_type;
+  typedef std::remove_const_t<Block> block_type;
+  typedef std::size_t size_type;
+  typedef std::ptrdiff_t difference_type;
+  typedef std::conditional_t<std::is_const_v<Block>, value_type, XbitReference<N, block_type>>
+      reference;
+  typedef value_type const_reference;
+  typedef std::conditional_t<
+      std::is_const_v<Block>, XbitConstIterator<N, block_type>, XbitIterator<N, block_type>>
+      iterator;
+  typedef XbitConstIterator<N, block_type> const_iterator;
+  typedef std::reverse_iterator<iterator> reverse_iterator;
+  typedef std::reverse_iterator<const_iterator> const_reverse_iterator;
+
+  constexpr static std::size_t xbits_per_block = iterator::xbits_per_block;
+
+ private:
+  iterator first_{};
+  size_type size_{};
+
+ public:
+  constexpr XbitSpan() noexcept = default;
+
+  constexpr XbitSpan(Block* data, size_type size) noexcept
+      : first_(const_cast<block_type*>(data), 0), size_(size) {}
+
+  constexpr XbitSpan(iterator first, size_type size) noexcept : first_(first), size_(size) {}
+
+  constexpr XbitSpan(iterator first, iterator last) noexcept
+      : first_(first), size_(static_cast<size_type>(last - first)) {}
+
+  template <std::copy_constructible Allocator, std::size_t InlineBlocks>
+  constexpr XbitSpan(XbitVector<N, block_type, Allocator, InlineBlocks>& v) noexcept
+      : first_(v.begin()), size_(v.size()) {}
+
+  template <std::copy_constructible Allocator, std::size_t InlineBlocks>
+  constexpr XbitSpan(const XbitVector<N, block_type, Allocator, InlineBlocks>& v) noexcept
+      requires std::is_const_v<Block> : first_(v.begin()), size_(v.size()) {}
+
+  template <typename B>
+  requires(std::is_const_v<Block> && std::same_as<B, block_type>)
+  constexpr XbitSpan(const XbitSpan<N, B>& s) noexcept : first_(s.begin()), size_(s.size()) {}
+
+  constexpr iterator begin() const noexcept { return first_; }
+
+  constexpr iterator end() const noexcept { return first_ + size_; }
+
+  constexpr const_iterator cbegin() const noexcept { return first_; }
+
+  constexpr const_iterator cend() const noexcept { return end(); }
+
+  constexpr reverse_iterator rbegin() const noexcept { return reverse_iterator(end()); }
+
+  constexpr reverse_iterator rend() const noexcept { return reverse_iterator(begin()); }
+
+  constexpr const_reverse_iterator crbegin() const noexcept {
+    return const_reverse_iterator(end());
+  }
+
+  constexpr const_reverse_iterator crend() const noexcept {
+    return const_reverse_iterator(begin());
+  }
+
+  constexpr size_type size() const noexcept { return size_; }
+
+  [[nodiscard]] constexpr bool empty() const noexcept { return size_ == 0; }
+
+  constexpr reference operator[](size_type n) const { return first_[n]; }
+
+  constexpr reference front() const { return *first_; }
+
+  constexpr reference back() const { return first_[size_ - 1]; }
+
+  // The block holding the first xbit, and the index of the xbit in it, or of its first bit when
+  // the xbits straddle blocks.
+  constexpr Block* data() const noexcept { return first_.segment(); }
+
+  constexpr size_type offset() const noexcept { return first_.offset(); }
+
+  constexpr std::uint64_t get_bits(size_type pos, size_type count) const noexcept {
+    assert(0 < count && count * N <= 64 && pos + count <= size_);
+    const auto bit = first_.bit_offset() + pos * N;
+    if (unchecked_word_access(bit))
+      return load_bits64_unchecked(
+          reinterpret_cast<const unsigned char*>(first_.segment()), bit, count * N);
+    return load_bits64(first_.segment(), bit, count * N);
+  }
+
+  constexpr void set_bits(size_type pos, size_type count, std::uint64_t value) const noexcept
+      requires(!std::is_const_v<Block>) {
+    assert(0 < count && count * N <= 64 && pos + count <= size_);
+    const auto bit = first_.bit_offset() + pos * N;
+    if (unchecked_word_access(bit))
+      store_bits64_unchecked(
+          reinterpret_cast<unsigned char*>(first_.segment()), bit, count * N, value);
+    else
+      store_bits64(first_.segment(), bit, count * N, value);
+  }
+
+  constexpr XbitSpan first(size_type n) const noexcept { return XbitSpan(first_, n); }
+
+  constexpr XbitSpan last(size_type n) const noexcept { return XbitSpan(end() - n, n); }
+
+  // The n xbits from pos, or all of them up to the end.
+  constexpr XbitSpan subspan(size_type pos, size_type n = std::dynamic_extent) const noexcept {
+    return XbitSpan(first_ + pos, std::min(n, size_ - pos));
+  }
+
+  constexpr void flip() const noexcept requires(!std::is_const_v<Block>);
+
+ private:
+  // Whether the 9 bytes from the one holding bit are within the blocks of the span.
+  constexpr bool unchecked_word_access(size_type bit) const noexcept {
+    constexpr std::size_t W = block_bits<block_type>;
+    if constexpr (W < 64 && std::endian::native == std::endian::little)
+      return !std::is_constant_evaluated() &&
+             bit / CHAR_BIT + 9 <= (first_.bit_offset() + size_ * N + W - 1) / W * sizeof(Block);
+    else
+      return false;
+  }
+
+ public:
+
+  constexpr size_type count(value_type x) const noexcept {
+    return detail::count(first_, size_, x);
+  }
+
+  constexpr std::array<size_type, (1 << N)> histogram() const noexcept requires(N <= 8) {
+    return detail::histogram(first_, size_);
+  }
+
+  constexpr iterator find(value_type x) const noexcept { return detail::find(begin(), end(), x); }
+
+  constexpr iterator find_not(value_type x) const noexcept {
+    return detail::find_not(begin(), end(), x);
+  }
+
+  constexpr iterator find_first_of(std::initializer_list<value_type> il) const noexcept {
+    return detail::find_first_of(begin(), end(), il.begin(), il.end());
+  }
+
+  constexpr void reverse_complement() const noexcept requires(N == 2 && !std::is_const_v<Block>) {
+    detail::reverse_complement(begin(), end());
+  }
+
+  constexpr bool operator==(const XbitSpan& other) const noexcept {
+    return size_ == other.size_ && mismatch_length(first_, size_, other.first_) == size_;
+  }
+
+  constexpr std::strong_ordering operator<=>(const XbitSpan& other) const noexcept {
+    const size_type n = std::min(size_, other.size_);
+    const size_type i = mismatch_length(first_, n, other.first_);
+    if (i != n) return first_[i] <=> other.first_[i];
+    return size_ <=> other.size_;
+  }
+};
+
+template <std::size_t N, std::unsigned_integral Block>
+requires(N <= 8) constexpr void sort(XbitSpan<N, Block> s) noexcept { sort(s.begin(), s.end()); }
+
+template <std::size_t N, typename Block>
+requires std::unsigned_integral<std::remove_const_t<Block>>
+constexpr void XbitSpan<N, Block>::flip() const noexcept requires(!std::is_const_v<Block>) {
+  constexpr std::size_t W = block_bits<block_type>;
+  block_type* p = first_.segment();
+  std::size_t off = first_.bit_offset(), n = size_ * N;
+  if (n == 0) return;
+  if (off != 0) {
+    const std::size_t k = std::min(W - off, n);
+    *p++ ^= static_cast<block_type>(low_mask<block_type>(k) << off);
+    n -= k;
+  }
+  for (; n >= W; n -= W, ++p) *p = static_cast<block_type>(~*p);
+  if (n) *p ^= low_mask<block_type>(n);
+}
+
 }  // namespace biomodern::detail
 
+namespace std::ranges {
+
+template <std::size_t N, typename Block>
+inline constexpr bool enable_view<biomodern::detail::XbitSpan<N, Block>> = true;
+
+template <std::size_t N, typename Block>
+inline constexpr bool enable_borrowed_range<biomodern::detail::XbitSpan<N, Block>> = true;
+
+}  // namespace std::ranges
+
 namespace biomodern {
 
 template <
@@ -1046,4 +2601,50 @@ template <
     std::copy_constructible Allocator = std::allocator<Block> >
 using QuadbitVector = detail::XbitVector<4, Block, Allocator>;
 
+static_assert(sizeof(DibitVector<>) == 3 * sizeof(void*));
+
+// Any width from 1 to 16 bits, e.g. XbitVector<5> for amino acids. Widths which do not divide the
+// block width are packed without padding and use the slower straddling accessors, bulk copies and
+// comparisons still move whole blocks.
+template <
+    std::size_t N, std::unsigned_integral Block = std::uint8_t,
+    std::copy_constructible Allocator = std::allocator<Block> >
+using XbitVector = detail::XbitVector<N, Block, Allocator>;
+
+// Vectors holding up to InlineBlocks blocks within the object, short sequences then take no
+// allocation. Longer ones spill to the allocator, the interface and iterators are unchanged.
+template <
+    std::size_t InlineBlocks, std::unsigned_integral Block = std::uint8_t,
+    std::copy_constructible Allocator = std::allocator<Block> >
+using SmallDibitVector = detail::XbitVector<2, Block, Allocator, InlineBlocks>;
+
+template <
+    std::size_t InlineBlocks, std::unsigned_integral Block = std::uint8_t,
+    std::copy_constructible Allocator = std::allocator<Block> >
+using SmallQuadbitVector = detail::XbitVector<4, Block, Allocator, InlineBlocks>;
+
+static_assert(sizeof(SmallDibitVector<8>) == 4 * sizeof(void*));
+
+template <typename Block = std::uint8_t>
+using DibitSpan = detail::XbitSpan<2, Block>;
+
+template <typename Block = std::uint8_t>
+using QuadbitSpan = detail::XbitSpan<4, Block>;
+
+template <std::size_t N, typename Block = std::uint8_t>
+using XbitSpan = detail::XbitSpan<N, Block>;
+
 }  // namespace biomodern
+
+namespace biomodern::pmr {
+
+// Vectors drawing their blocks from a std::pmr::memory_resource. As for the std::pmr
+// containers the resource sticks to the vector: copies use the default resource, and assignment
+// and swap keep the resources in place (swap requires them to be equal).
+template <std::unsigned_integral Block = std::uint8_t>
+using DibitVector = biomodern::DibitVector<Block, std::pmr::polymorphic_allocator<Block>>;
+
+template <std::unsigned_integral Block = std::uint8_t>
+using QuadbitVector = biomodern::QuadbitVector<Block, std::pmr::polymorphic_allocator<Block>>;
+
+}  // namespace biomodern::pmr
@@ -1,6 +1,19 @@
 #include <algorithm>
+#include <cctype>
+#include <iterator>
+#include <memory_resource>
 #include <sstream>
 #include <string>
+#include <vector>
+#include <xbit_vector/ascii.hpp>
+#include <xbit_vector/distance.hpp>
+#include <xbit_vector/fastx.hpp>
+#include <xbit_vector/io.hpp>
+#include <xbit_vector/kmers.hpp>
+#include <xbit_vector/parallel.hpp>
+#include <xbit_vector/rank_index.hpp>
+#include <xbit_vector/string_set.hpp>
+#include <xbit_vector/symbols.hpp>
 #include <xbit_vector/xbit_vector.hpp>
 
 #include <catch2/catch.hpp>
@@ -374,4 +387,1242 @@ TEST_CASE("dibit_vector") {
     REQUIRE(v[2] == 3);
     REQUIRE(-v[2] == -3);
   }
-}
\ No newline at end of file
+}
+template <typename V>
+V make_sequence(std::size_t n, unsigned seed = 1) {
+  V v;
+  for (std::size_t i = 0; i < n; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    v.push_back(static_cast<typename V::value_type>(seed >> 16));
+  }
+  return v;
+}
+
+template <typename V>
+std::vector<std::uint8_t> to_bytes(const V& v) {
+  return std::vector<std::uint8_t>(v.begin(), v.end());
+}
+
+TEMPLATE_TEST_CASE("block-level algorithms", "", std::uint8_t, std::uint16_t,
+                   std::uint32_t, std::uint64_t) {
+  using Dibit = DibitVector<TestType>;
+  using Quadbit = QuadbitVector<TestType>;
+  const auto d = make_sequence<Dibit>(300);
+  const auto q = make_sequence<Quadbit>(300, 7);
+
+  SECTION("copy at every offset pair") {
+    for (std::size_t so = 0; so < 40; so += 3)
+      for (std::size_t dst_off = 0; dst_off < 40; dst_off += 5) {
+        Dibit v(300);
+        auto ref = to_bytes(v);
+        const auto src = to_bytes(d);
+        std::copy(src.begin() + so, src.begin() + so + 200, ref.begin() + dst_off);
+        copy(d.begin() + so, d.begin() + so + 200, v.begin() + dst_off);
+        REQUIRE(to_bytes(v) == ref);
+      }
+  }
+
+  SECTION("overlapping copy and copy_backward") {
+    for (std::size_t shift = 1; shift < 70; shift += 7) {
+      auto v = q;
+      auto ref = to_bytes(q);
+      std::copy_backward(ref.begin() + 5, ref.begin() + 200, ref.begin() + 200 + shift);
+      copy_backward(v.begin() + 5, v.begin() + 200, v.begin() + 200 + shift);
+      REQUIRE(to_bytes(v) == ref);
+      std::copy(ref.begin() + 10 + shift, ref.end(), ref.begin() + 10);
+      copy(v.begin() + 10 + shift, v.end(), v.begin() + 10);
+      REQUIRE(to_bytes(v) == ref);
+    }
+  }
+
+  SECTION("swap_ranges") {
+    for (std::size_t off = 0; off < 20; ++off) {
+      auto v = d;
+      auto ref = to_bytes(d);
+      std::swap_ranges(ref.begin() + 3, ref.begin() + 120, ref.begin() + 140 + off);
+      swap_ranges(v.begin() + 3, v.begin() + 120, v.begin() + 140 + off);
+      REQUIRE(to_bytes(v) == ref);
+    }
+  }
+
+  SECTION("rotate") {
+    for (std::size_t len : {17u, 300u})
+      for (std::size_t mid = 0; mid <= len; mid += 13) {
+        auto v = make_sequence<Dibit>(len + 9, static_cast<unsigned>(mid));
+        auto ref = to_bytes(v);
+        auto r = rotate(v.begin() + 9, v.begin() + 9 + mid, v.end());
+        std::rotate(ref.begin() + 9, ref.begin() + 9 + mid, ref.end());
+        REQUIRE(to_bytes(v) == ref);
+        REQUIRE(r - v.begin() == static_cast<std::ptrdiff_t>(9 + len - mid));
+      }
+  }
+
+  SECTION("fill and fill_n") {
+    for (std::size_t off = 0; off < 20; ++off)
+      for (std::uint8_t x = 0; x < 16; x += 5) {
+        auto v = q;
+        auto ref = to_bytes(q);
+        std::fill(ref.begin() + off, ref.end() - 2 * off, x);
+        fill(v.begin() + off, v.end() - 2 * off, x);
+        REQUIRE(to_bytes(v) == ref);
+      }
+    Dibit v(1001, 3);
+    REQUIRE(std::count(v.begin(), v.end(), 3) == 1001);
+    v.resize(2000, 1);
+    REQUIRE(std::count(v.begin(), v.end(), 1) == 999);
+    v.resize_for_overwrite(4000);
+    REQUIRE(v.size() == 4000);
+    REQUIRE(std::count(v.begin(), v.begin() + 2000, 1) == 999);
+    v.resize_for_overwrite(1001);
+    REQUIRE(std::count(v.begin(), v.end(), 3) == 1001);
+    v.assign(5, 2);
+    REQUIRE(to_bytes(v) == std::vector<std::uint8_t>(5, 2));
+  }
+
+  SECTION("comparison and mismatch") {
+    for (std::size_t i = 0; i < 300; i += 11) {
+      auto v = d;
+      v[i] = static_cast<std::uint8_t>(3 - v[i]);
+      const auto a = to_bytes(d), b = to_bytes(v);
+      REQUIRE((d == v) == (a == b));
+      REQUIRE((d <=> v) == (a <=> b));
+      REQUIRE(mismatch(d, v).first - d.begin() == static_cast<std::ptrdiff_t>(i));
+      auto w = d;
+      w.resize(i);
+      REQUIRE((d <=> w) == (a <=> to_bytes(w)));
+      REQUIRE((w <=> v) == (to_bytes(w) <=> b));
+      REQUIRE(mismatch(d, w).first == d.begin() + i);
+    }
+    for (std::size_t off = 0; off < 40; ++off) {
+      auto [p1, p2] = mismatch(d.begin() + off, d.end(), d.begin() + 2 * off, d.end());
+      const auto a = to_bytes(d);
+      auto [r1, r2] = std::mismatch(a.begin() + off, a.end(), a.begin() + 2 * off, a.end());
+      REQUIRE(p1 - d.begin() == r1 - a.begin());
+      REQUIRE(p2 - d.begin() == r2 - a.begin());
+    }
+  }
+
+  SECTION("count and histogram") {
+    const auto a = to_bytes(d), b = to_bytes(q);
+    for (std::uint8_t x = 0; x < 16; ++x) {
+      REQUIRE(q.count(x) == static_cast<std::size_t>(std::count(b.begin(), b.end(), x)));
+      REQUIRE(q.histogram()[x] == q.count(x));
+      if (x < 4) {
+        REQUIRE(d.count(x) == static_cast<std::size_t>(std::count(a.begin(), a.end(), x)));
+        REQUIRE(d.histogram()[x] == d.count(x));
+      }
+    }
+    for (std::size_t off = 0; off < 40; off += 3) {
+      auto first = d.begin() + off, last = d.end() - 2 * off;
+      REQUIRE(count(first, last, 2) == std::count(a.begin() + off, a.end() - 2 * off, 2));
+      const auto h = histogram(first, last);
+      REQUIRE(h[1] == static_cast<std::size_t>(std::count(a.begin() + off, a.end() - 2 * off, 1)));
+      REQUIRE(h[0] + h[1] + h[2] + h[3] == a.size() - 3 * off);
+    }
+  }
+
+  SECTION("find, find_not and find_first_of") {
+    auto v = Quadbit(700, 5);
+    for (auto i : {17, 130, 131, 400, 699}) v[i] = static_cast<std::uint8_t>(i % 3);
+    const auto a = to_bytes(v);
+    const std::uint8_t set[] = {1, 2, 200};
+    for (std::size_t off = 0; off < 150; off += 7) {
+      auto first = v.cbegin() + off;
+      auto last = v.cend() - off / 2;
+      auto b = a.begin() + off, e = a.end() - off / 2;
+      for (std::uint8_t x = 0; x < 6; ++x) {
+        REQUIRE(find(first, last, x) - first == std::find(b, e, x) - b);
+        REQUIRE(find_not(first, last, x) - first ==
+                std::find_if(b, e, [=](auto y) { return y != x; }) - b);
+      }
+      REQUIRE(find_first_of(first, last, std::begin(set), std::end(set)) - first ==
+              std::find_first_of(b, e, std::begin(set), std::end(set)) - b);
+    }
+    REQUIRE(v.find(1) - v.begin() == 130);
+    REQUIRE(v.find_not(5) - v.begin() == 17);
+    REQUIRE(v.find_first_of({0, 1}) - v.begin() == 130);
+    REQUIRE(v.find_first_of({}) == v.end());
+    REQUIRE(d.find_first_of({0, 1, 2, 3}) == d.begin());
+    REQUIRE(d.find_not(d[0]) - d.begin() ==
+            std::find_if(d.begin(), d.end(), [&](auto y) { return y != d[0]; }) - d.begin());
+
+    // Values out of the range of the xbits match nothing, as for std::find.
+    auto z = Quadbit(100, 0);
+    z[7] = 1;
+    for (const int x : {257, -1, 256, 16}) {
+      REQUIRE(find(z.cbegin(), z.cend(), x) == z.cend());
+      REQUIRE(find_not(z.cbegin(), z.cend(), x) == z.cbegin());
+      const int s[] = {x, 513};
+      REQUIRE(find_first_of(z.cbegin(), z.cend(), std::begin(s), std::end(s)) == z.cend());
+    }
+    REQUIRE(find(z.cbegin(), z.cend(), 257u) == z.cend());
+    REQUIRE(find(z.cbegin(), z.cend(), 1u) - z.cbegin() == 7);
+  }
+
+  SECTION("insert and erase in the middle") {
+    auto v = q;
+    auto ref = to_bytes(q);
+    v.insert(v.begin() + 33, 5, 9);
+    ref.insert(ref.begin() + 33, 5, 9);
+    v.insert(v.begin() + 1, d.begin(), d.end());
+    ref.insert(ref.begin() + 1, d.begin(), d.end());
+    v.erase(v.begin() + 7, v.begin() + 150);
+    ref.erase(ref.begin() + 7, ref.begin() + 150);
+    REQUIRE(to_bytes(v) == ref);
+  }
+}
+
+TEMPLATE_TEST_CASE("reverse complement", "", std::uint8_t, std::uint16_t,
+                   std::uint32_t, std::uint64_t) {
+  using Dibit = DibitVector<TestType>;
+  auto reference = [](const std::vector<std::uint8_t>& v) {
+    std::vector<std::uint8_t> r;
+    for (auto it = v.rbegin(); it != v.rend(); ++it) r.push_back(3 - *it);
+    return r;
+  };
+  for (std::size_t n : {0u, 1u, 2u, 3u, 31u, 64u, 65u, 127u, 300u, 1000u}) {
+    const auto d = make_sequence<Dibit>(n, static_cast<unsigned>(n));
+    const auto ref = reference(to_bytes(d));
+    auto v = d;
+    v.reverse_complement();
+    REQUIRE(to_bytes(v) == ref);
+    Dibit out{1, 2};
+    d.reverse_complement(out);
+    REQUIRE(out == v);
+    v.reverse_complement();
+    REQUIRE(v == d);
+  }
+  SECTION("sub-ranges") {
+    const auto d = make_sequence<Dibit>(600);
+    for (std::size_t first = 0; first < 40; first += 3)
+      for (std::size_t last = 560; last <= 600; last += 7) {
+        auto v = d;
+        auto ref = to_bytes(d);
+        reverse_complement(v.begin() + first, v.begin() + last);
+        std::reverse(ref.begin() + first, ref.begin() + last);
+        std::for_each(ref.begin() + first, ref.begin() + last, [](auto& x) { x = 3 - x; });
+        REQUIRE(to_bytes(v) == ref);
+        Dibit out(600);
+        auto ref_out = to_bytes(out);
+        reverse_complement_copy(d.begin() + first, d.begin() + last, out.begin() + (600 - last));
+        std::copy(ref.begin() + first, ref.begin() + last, ref_out.begin() + (600 - last));
+        REQUIRE(to_bytes(out) == ref_out);
+      }
+  }
+}
+
+TEMPLATE_TEST_CASE("ascii codecs", "", std::uint8_t, std::uint16_t, std::uint32_t,
+                   std::uint64_t) {
+  std::string bases;
+  std::string iupac;
+  unsigned seed = 3;
+  for (std::size_t i = 0; i < 333; ++i) {
+    seed = seed * 1103515245u + 12345u;
+    bases += "ACGTacgt"[seed >> 16 & 7];
+    iupac += "=ACMGRSVTWYHKDBNacmgrsvtwyhkdbn"[(seed >> 16) % 31];
+  }
+  SECTION("dibit") {
+    DibitVector<TestType> v{2};
+    REQUIRE(pack_ascii(bases, v) == 0);
+    REQUIRE(pack_ascii("ACNT", v) == 1);
+    REQUIRE(v.size() == bases.size() + 5);
+    REQUIRE(v[0] == 2);
+    for (std::size_t i = 0; i < bases.size(); ++i)
+      REQUIRE(v[i + 1] == std::string_view("ACGT").find(std::toupper(bases[i])));
+    REQUIRE(v[bases.size() + 3] == 0);
+    std::string out(v.size(), ' ');
+    unpack_ascii(v, out.data());
+    for (auto& c : bases) c = static_cast<char>(std::toupper(c));
+    REQUIRE(out == "G" + bases + "ACAT");
+  }
+  SECTION("quadbit") {
+    QuadbitVector<TestType> v;
+    REQUIRE(pack_iupac(iupac, v) == 0);
+    REQUIRE(pack_iupac("-uX.", v) == 2);
+    std::string out(v.size(), ' ');
+    unpack_iupac(v, out.data());
+    for (auto& c : iupac) c = static_cast<char>(std::toupper(c));
+    REQUIRE(out == iupac + "=TNN");
+  }
+}
+
+TEMPLATE_TEST_CASE("rank and select", "", std::uint8_t, std::uint16_t, std::uint32_t,
+                   std::uint64_t) {
+  using namespace biomodern;
+  const auto check = [](const auto& v, const auto& index) {
+    constexpr auto sigma = std::remove_cvref_t<decltype(index)>::sigma;
+    REQUIRE(index.size() == v.size());
+    std::vector<std::size_t> ranks(sigma);
+    for (std::size_t i = 0; i <= v.size(); ++i) {
+      for (std::uint8_t c = 0; c < sigma; ++c) REQUIRE(index.rank(c, i) == ranks[c]);
+      if (i == v.size()) break;
+      REQUIRE(index.select(v[i], ranks[v[i]]) == i);
+      ++ranks[v[i]];
+    }
+    for (std::uint8_t c = 0; c < sigma; ++c) {
+      REQUIRE(index.count(c) == ranks[c]);
+      REQUIRE(index.select(c, ranks[c]) == v.size());
+    }
+  };
+  for (auto n : {0, 1, 1023, 1024, 5000}) {
+    const auto d = make_sequence<DibitVector<TestType>>(n, n);
+    check(d, DibitRankIndex<TestType>(d));
+  }
+  for (auto n : {0, 4096, 9001}) {
+    auto q = make_sequence<QuadbitVector<TestType>>(n, n);
+    // Long runs of a single value make some counters reach their largest values.
+    std::fill(q.begin() + n / 3, q.end(), 7);
+    check(q, QuadbitRankIndex<TestType>(q));
+  }
+  // The index refers to the blocks of the vector, which a temporary would not keep alive.
+  STATIC_REQUIRE(std::constructible_from<DibitRankIndex<TestType>, const DibitVector<TestType>&>);
+  STATIC_REQUIRE(!std::constructible_from<DibitRankIndex<TestType>, DibitVector<TestType>>);
+  STATIC_REQUIRE(!std::constructible_from<DibitRankIndex<TestType>, SmallDibitVector<4, TestType>>);
+  const SmallDibitVector<4, TestType> small(100, 2);
+  REQUIRE(DibitRankIndex<TestType>(small).count(2) == 100);
+}
+
+TEMPLATE_TEST_CASE("k-mers", "", std::uint8_t, std::uint16_t, std::uint32_t, std::uint64_t) {
+  using namespace biomodern;
+  const auto v = make_sequence<DibitVector<TestType>>(300, 3);
+  const auto naive = [&](auto kmer, std::size_t i, std::size_t k, bool canonical) {
+    decltype(kmer) fwd = 0, rev = 0;
+    for (std::size_t j = 0; j < k; ++j) {
+      fwd = fwd << 2 | v[i + j];
+      rev = rev << 2 | (3 ^ v[i + k - 1 - j]);
+    }
+    return canonical ? std::min(fwd, rev) : fwd;
+  };
+  const auto check = [&](auto kmer, auto&& view, std::size_t first, std::size_t last,
+                         std::size_t k, bool canonical) {
+    REQUIRE(view.size() == (last - first < k ? 0 : last - first - k + 1));
+    std::size_t i = first;
+    for (auto x : view) REQUIRE(x == naive(kmer, i++, k, canonical));
+    REQUIRE(i - first == view.size());
+  };
+  static_assert(std::ranges::forward_range<decltype(kmers(v, 1))>);
+  static_assert(std::ranges::borrowed_range<decltype(kmers(v, 1))>);
+  for (std::size_t k : {1, 2, 15, 31, 32}) {
+    check(std::uint64_t{}, kmers(v, k), 0, v.size(), k, false);
+    check(std::uint64_t{}, canonical_kmers(v, k), 0, v.size(), k, true);
+    for (std::size_t first : {1, 7, 100, 290})
+      check(std::uint64_t{}, canonical_kmers(v.begin() + first, v.end() - 3, k), first,
+            v.size() - 3, k, true);
+  }
+  for (std::size_t k : {33, 64}) {
+    check(__uint128_t{}, kmers<__uint128_t>(v, k), 0, v.size(), k, false);
+    check(__uint128_t{}, canonical_kmers<__uint128_t>(v, k), 0, v.size(), k, true);
+  }
+  const DibitVector<TestType> short_v(4);
+  REQUIRE(std::ranges::empty(kmers(short_v, 5)));
+}
+
+TEMPLATE_TEST_CASE("spans", "", std::uint8_t, std::uint16_t, std::uint32_t, std::uint64_t) {
+  using namespace biomodern;
+  auto v = make_sequence<DibitVector<TestType>>(300, 5);
+  const auto a = to_bytes(v);
+
+  static_assert(std::ranges::view<DibitSpan<TestType>>);
+  static_assert(std::ranges::borrowed_range<QuadbitSpan<const TestType>>);
+  static_assert(std::ranges::random_access_range<DibitSpan<const TestType>>);
+
+  SECTION("construction and subspans") {
+    DibitSpan<TestType> s = v;
+    DibitSpan<const TestType> c = s;
+    REQUIRE(std::ranges::equal(s, v));
+    REQUIRE(std::ranges::equal(c, DibitSpan<const TestType>(v.data(), v.size())));
+    for (std::size_t pos : {0, 1, 3, 17, 64, 299}) {
+      const auto sub = c.subspan(pos, 100);
+      REQUIRE(sub.size() == std::min<std::size_t>(100, 300 - pos));
+      REQUIRE(std::ranges::equal(sub, std::vector(a.begin() + pos, a.begin() + pos + sub.size())));
+      REQUIRE(sub.count(2) == static_cast<std::size_t>(std::ranges::count(sub, 2)));
+      REQUIRE(sub.find(3) == std::ranges::find(sub, 3));
+      REQUIRE(sub == DibitSpan<const TestType>(v.begin() + pos, sub.size()));
+    }
+    for (std::size_t pos : {1, 2, 9})
+      REQUIRE((c.first(40) <=> c.subspan(pos, 40)) ==
+              std::lexicographical_compare_three_way(
+                  a.begin(), a.begin() + 40, a.begin() + pos, a.begin() + pos + 40));
+    REQUIRE(std::ranges::equal(c.last(5), c.subspan(295)));
+  }
+
+  SECTION("mutation through a span leaves the rest untouched") {
+    DibitSpan<TestType> s = DibitSpan<TestType>(v).subspan(7, 250);
+    s.flip();
+    s.reverse_complement();
+    for (std::size_t i = 0; i < v.size(); ++i) {
+      if (i < 7 || i >= 257) REQUIRE(v[i] == a[i]);
+      else
+        REQUIRE(v[i] == a[263 - i]);
+    }
+    fill(s.begin(), s.end(), 1);
+    const auto outside = std::count(a.begin(), a.begin() + 7, 1) +
+                         std::count(a.begin() + 257, a.end(), 1);
+    REQUIRE(v.count(1) == 250 + static_cast<std::size_t>(outside));
+  }
+
+  SECTION("algorithms on spans of external buffers") {
+    std::vector<TestType> buffer(v.data(), v.data() + v.num_blocks());
+    const DibitSpan<const TestType> s(buffer.data(), v.size());
+    REQUIRE(std::ranges::equal(s, v));
+    std::string text(s.size(), ' ');
+    unpack_ascii(s.subspan(3), text.data());
+    DibitVector<TestType> w(s.size() - 3);
+    pack_ascii(std::string_view(text).substr(0, w.size()), DibitSpan<TestType>(w));
+    REQUIRE(DibitSpan<const TestType>(w) == s.subspan(3));
+    REQUIRE(std::ranges::equal(kmers(s.subspan(5), 7), kmers(v.begin() + 5, v.end(), 7)));
+    const DibitRankIndex<TestType> index(s);
+    REQUIRE(index.rank(1, 200) == v.count(1) - DibitSpan<const TestType>(v).subspan(200).count(1));
+  }
+}
+
+TEMPLATE_TEST_CASE("save, load and map", "", std::uint8_t, std::uint16_t, std::uint32_t,
+                   std::uint64_t) {
+  using namespace biomodern;
+  const auto dir = std::filesystem::temp_directory_path();
+  const auto path = dir / ("xbit_vector_test_" + std::to_string(sizeof(TestType)) + ".xbv");
+  for (std::size_t n : {0, 1, 37, 1000}) {
+    const auto v = make_sequence<DibitVector<TestType>>(n, static_cast<unsigned>(n));
+    save(v, path);
+    REQUIRE(load<DibitVector<TestType>>(path) == v);
+    REQUIRE(load<DibitVector<std::uint64_t>>(path).size() == n);
+    REQUIRE(std::ranges::equal(load<DibitVector<std::uint8_t>>(path), v));
+    const auto m = map<DibitMapping<TestType>>(path, DibitMapping<TestType>::Advice::sequential);
+    REQUIRE(m.span() == DibitSpan<const TestType>(v));
+    REQUIRE(reinterpret_cast<std::uintptr_t>(m.data()) % 64 == 0);
+    if constexpr (std::endian::native == std::endian::little)
+      REQUIRE(std::ranges::equal(map<DibitMapping<std::uint64_t>>(path), v));
+    if (n > 10) {
+      save(DibitSpan<const TestType>(v).subspan(3, n - 10), path);
+      auto w = make_sequence<DibitVector<TestType>>(5);
+      load(path, w);
+      REQUIRE(std::ranges::equal(w, DibitSpan<const TestType>(v).subspan(3, n - 10)));
+    }
+  }
+  REQUIRE_THROWS_AS(load<QuadbitVector<TestType>>(path), std::runtime_error);
+  REQUIRE_THROWS_AS(map<QuadbitMapping<TestType>>(path), std::runtime_error);
+  {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out << "not an xbit vector file, but long enough to hold a header............................";
+  }
+  REQUIRE_THROWS_AS(load<DibitVector<TestType>>(path), std::runtime_error);
+  std::filesystem::remove(path);
+  REQUIRE_THROWS_AS(map<DibitMapping<TestType>>(path), std::runtime_error);
+}
+
+TEMPLATE_TEST_CASE("fastx reader", "", std::uint8_t, std::uint16_t, std::uint32_t,
+                   std::uint64_t) {
+  using namespace biomodern;
+  const std::string fasta =
+      ">chr1 first\nACGTNNacgt\r\nGGGGRYCC\n\n; comment\nTTTT\n"
+      ">chr2\n>chr3\nNNNN\nNACG";
+  const std::string fastq =
+      "@read1\nACGTN\n+\n@@@@@\n@read2 two lines\nAC\nGT\n+read2\n!!\n##\n\n@read3\n\n+\n";
+  const auto read_all = [](FastxReader<TestType>& reader) {
+    std::vector<FastxRecord<TestType>> records;
+    for (FastxRecord<TestType> r; reader.read(r);) records.push_back(r);
+    return records;
+  };
+  const auto to_string = [](const DibitVector<TestType>& v) {
+    std::string s(v.size(), ' ');
+    unpack_ascii(v, s.data());
+    return s;
+  };
+  typedef std::vector<std::pair<std::size_t, std::size_t>> Runs;
+  for (std::size_t chunk_size : {1, 3, 7, 64, 1 << 20}) {
+    for (bool pipelined : {false, true}) {
+      const FastxOptions options{chunk_size, pipelined, 2};
+      {
+        std::istringstream in(fasta);
+        FastxReader<TestType> reader(in, options);
+        const auto records = read_all(reader);
+        REQUIRE(records.size() == 3);
+        REQUIRE(records[0].name == "chr1 first");
+        REQUIRE(to_string(records[0].seq) == "ACGTAAACGTGGGGAACCTTTT");
+        REQUIRE(records[0].ambiguous == Runs{{4, 6}, {14, 16}});
+        REQUIRE(records[0].qual.empty());
+        REQUIRE(records[1].name == "chr2");
+        REQUIRE(records[1].seq.empty());
+        REQUIRE(records[2].name == "chr3");
+        REQUIRE(to_string(records[2].seq) == "AAAAAACG");
+        REQUIRE(records[2].ambiguous == Runs{{0, 5}});
+      }
+      {
+        std::istringstream in(fastq);
+        FastxReader<TestType> reader(in, options);
+        const auto records = read_all(reader);
+        REQUIRE(records.size() == 3);
+        REQUIRE(records[0].name == "read1");
+        REQUIRE(to_string(records[0].seq) == "ACGTA");
+        REQUIRE(records[0].ambiguous == Runs{{4, 5}});
+        REQUIRE(records[0].qual == "@@@@@");
+        REQUIRE(records[1].name == "read2 two lines");
+        REQUIRE(to_string(records[1].seq) == "ACGT");
+        REQUIRE(records[1].ambiguous.empty());
+        REQUIRE(records[1].qual == "!!##");
+        REQUIRE(records[2].name == "read3");
+        REQUIRE(records[2].seq.empty());
+      }
+      for (const char* bad : {"ACGT\n", "@read\nACGT\n+\n!!!\n", "@read\nACGT\n"}) {
+        std::istringstream in(bad);
+        FastxReader<TestType> reader(in, options);
+        REQUIRE_THROWS_AS(read_all(reader), std::runtime_error);
+      }
+      {
+        std::istringstream in("@a\nACGT\n+\nIIII\n@b\nACGT\n+\nIIII\n@c\nAC\n");
+        FastxReader<TestType> reader(in, options);
+        FastxRecord<TestType> r;
+        REQUIRE(reader.read(r));
+        REQUIRE(r.name == "a");
+        REQUIRE(reader.read(r));
+        REQUIRE(r.name == "b");
+        REQUIRE_THROWS_AS(reader.read(r), std::runtime_error);
+        REQUIRE_FALSE(reader.read(r));
+      }
+    }
+  }
+  const auto path = std::filesystem::temp_directory_path() /
+                    ("xbit_vector_test_" + std::to_string(sizeof(TestType)) + ".fa");
+  std::ofstream(path, std::ios::binary) << fasta;
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  REQUIRE(fd >= 0);
+  {
+    FastxReader<TestType> reader(fd, {.chunk_size = 5, .pipelined = true});
+    REQUIRE(read_all(reader).size() == 3);
+  }
+  ::close(fd);
+  std::filesystem::remove(path);
+}
+
+TEMPLATE_TEST_CASE("parallel kernels", "", std::uint8_t, std::uint16_t, std::uint32_t,
+                   std::uint64_t) {
+  using namespace biomodern;
+  ThreadPool pool(4);
+  for (std::size_t n : {std::size_t{100}, std::size_t{5'000'003}}) {
+    const auto v = make_sequence<DibitVector<TestType>>(n, 3);
+    const auto q = make_sequence<QuadbitVector<TestType>>(n / 2, 5);
+    SECTION("flip, fill, count and histogram") {
+      auto w = v, expected = v;
+      flip(pool, w);
+      expected.flip();
+      REQUIRE(w == expected);
+      flip(pool, DibitSpan<TestType>(w).subspan(7, n - 20));
+      DibitSpan<TestType>(expected).subspan(7, n - 20).flip();
+      REQUIRE(w == expected);
+      fill(pool, DibitSpan<TestType>(w).subspan(5, n - 9), 2);
+      std::fill(expected.begin() + 5, expected.end() - 4, 2);
+      REQUIRE(w == expected);
+      REQUIRE(count(pool, v, 1) == v.count(1));
+      REQUIRE(count(pool, DibitSpan<const TestType>(v).subspan(3), 1) ==
+              DibitSpan<const TestType>(v).subspan(3).count(1));
+      REQUIRE(histogram(pool, v) == v.histogram());
+      REQUIRE(histogram(pool, q) == q.histogram());
+    }
+    SECTION("equal") {
+      auto w = v;
+      REQUIRE(equal(pool, v, w));
+      REQUIRE(equal(
+          pool, DibitSpan<const TestType>(v).subspan(1), DibitSpan<TestType>(w).subspan(1)));
+      w[n - 2] = static_cast<std::uint8_t>(~w[n - 2]);
+      REQUIRE_FALSE(equal(pool, v, w));
+      REQUIRE_FALSE(equal(
+          pool, DibitSpan<const TestType>(v).subspan(1), DibitSpan<TestType>(w).subspan(2)));
+    }
+    SECTION("reverse complement") {
+      for (std::size_t first : {0, 1, 5, 17}) {
+        for (std::size_t last : {n, n - 1, n - 6}) {
+          auto w = v, expected = v;
+          reverse_complement(pool, DibitSpan<TestType>(w).subspan(first, last - first));
+          DibitSpan<TestType>(expected).subspan(first, last - first).reverse_complement();
+          REQUIRE(w == expected);
+        }
+      }
+      auto w = v;
+      reverse_complement(pool, w);
+      w.reverse_complement();
+      REQUIRE(w == v);
+    }
+    SECTION("ascii codecs") {
+      std::string s(n, ' '), t(n, ' ');
+      unpack_ascii(v, s.data());
+      REQUIRE(unpack_ascii(pool, v, t.data()) == t.data() + n);
+      REQUIRE(s == t);
+      s[n / 2] = 'N';
+      DibitVector<TestType> w(3, 1);
+      REQUIRE(pack_ascii(pool, s, w) == 1);
+      REQUIRE(w.size() == n + 3);
+      DibitVector<TestType> expected(3, 1);
+      pack_ascii(s, expected);
+      REQUIRE(w == expected);
+      REQUIRE(
+          pack_ascii(pool, std::string_view(s).substr(9), DibitSpan<TestType>(w).subspan(3)) == 1);
+      std::string u(q.size(), ' ');
+      unpack_iupac(q, u.data());
+      QuadbitVector<TestType> x;
+      REQUIRE(pack_iupac(pool, u, x) == 0);
+      REQUIRE(x == q);
+      REQUIRE(unpack_iupac(pool, QuadbitSpan<const TestType>(x), t.data()) == t.data() + q.size());
+      REQUIRE(t.substr(0, q.size()) == u);
+    }
+  }
+  REQUIRE_THROWS_AS(
+      pool.run(8, [](std::size_t i) {
+        if (i == 5) throw std::runtime_error("task");
+      }),
+      std::runtime_error);
+}
+
+// Counts the blocks drawn from it, and checks that they are returned to it.
+class CountingResource : public std::pmr::memory_resource {
+  std::pmr::memory_resource* upstream_ = std::pmr::new_delete_resource();
+
+ public:
+  std::size_t allocations = 0, live = 0;
+
+  ~CountingResource() { REQUIRE(live == 0); }
+
+ private:
+  void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+    ++allocations;
+    ++live;
+    return upstream_->allocate(bytes, alignment);
+  }
+
+  void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+    --live;
+    upstream_->deallocate(p, bytes, alignment);
+  }
+
+  bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+    return this == &other;
+  }
+};
+
+TEMPLATE_TEST_CASE("allocators", "", std::uint8_t, std::uint16_t, std::uint32_t,
+                   std::uint64_t) {
+  using namespace biomodern;
+  STATIC_REQUIRE(sizeof(DibitVector<TestType>) == 3 * sizeof(void*));
+  STATIC_REQUIRE(sizeof(QuadbitVector<TestType>) == 3 * sizeof(void*));
+  STATIC_REQUIRE(sizeof(pmr::DibitVector<TestType>) == 4 * sizeof(void*));
+  CountingResource r1, r2;
+  const auto expected = make_sequence<DibitVector<TestType>>(1000);
+  pmr::DibitVector<TestType> v(expected.begin(), expected.end(), &r1);
+  REQUIRE(std::ranges::equal(v, expected));
+  REQUIRE(v.get_allocator().resource() == &r1);
+  REQUIRE(r1.allocations == 1);
+  SECTION("copy") {
+    pmr::DibitVector<TestType> w(v);
+    REQUIRE(w == v);
+    REQUIRE(w.get_allocator().resource() == std::pmr::get_default_resource());
+    pmr::DibitVector<TestType> x(v, &r2);
+    REQUIRE(x == v);
+    REQUIRE(x.get_allocator().resource() == &r2);
+    pmr::DibitVector<TestType> y(&r2);
+    y = v;
+    REQUIRE(y == v);
+    REQUIRE(y.get_allocator().resource() == &r2);
+  }
+  SECTION("move") {
+    pmr::DibitVector<TestType> w(std::move(v));
+    REQUIRE(std::ranges::equal(w, expected));
+    REQUIRE(w.get_allocator().resource() == &r1);
+    REQUIRE(r1.allocations == 1);
+    pmr::DibitVector<TestType> x(std::move(w), &r2);
+    REQUIRE(std::ranges::equal(x, expected));
+    REQUIRE(x.get_allocator().resource() == &r2);
+    REQUIRE(r2.allocations == 1);
+    pmr::DibitVector<TestType> y(&r1);
+    y = std::move(x);
+    REQUIRE(std::ranges::equal(y, expected));
+    REQUIRE(y.get_allocator().resource() == &r1);
+    REQUIRE(r1.allocations == 2);
+    pmr::DibitVector<TestType> z(&r1);
+    z = std::move(y);
+    REQUIRE(std::ranges::equal(z, expected));
+    REQUIRE(r1.allocations == 2);
+  }
+  SECTION("swap and growth") {
+    pmr::DibitVector<TestType> w(&r1);
+    w.swap(v);
+    REQUIRE(v.empty());
+    REQUIRE(std::ranges::equal(w, expected));
+    for (std::size_t i = 0; i < 10000; ++i) w.push_back(i % 4);
+    w.shrink_to_fit();
+    REQUIRE(w.get_allocator().resource() == &r1);
+    REQUIRE(r2.allocations == 0);
+  }
+  SECTION("arena") {
+    std::array<std::byte, 1 << 12> buffer;
+    std::pmr::monotonic_buffer_resource arena(
+        buffer.data(), buffer.size(), std::pmr::null_memory_resource());
+    std::pmr::vector<pmr::DibitVector<TestType>> reads(&arena);
+    for (std::size_t i = 0; i < 16; ++i)
+      reads.emplace_back(expected.begin(), expected.begin() + 50);
+    REQUIRE(reads.back().get_allocator().resource() == &arena);
+    REQUIRE(std::ranges::equal(reads.front(), expected | std::views::take(50)));
+  }
+}
+
+TEMPLATE_TEST_CASE("small vectors", "", std::uint8_t, std::uint16_t, std::uint32_t,
+                   std::uint64_t) {
+  using namespace biomodern;
+  using Small = SmallDibitVector<4, TestType, std::pmr::polymorphic_allocator<TestType>>;
+  STATIC_REQUIRE(std::same_as<typename Small::iterator, typename DibitVector<TestType>::iterator>);
+  constexpr std::size_t inline_size = 4 * Small::xbits_per_block;
+  CountingResource r;
+  const auto expected = make_sequence<DibitVector<TestType>>(inline_size * 3);
+  const auto short_read = expected | std::views::take(inline_size);
+  Small v(&r);
+  REQUIRE(v.capacity() == inline_size);
+  v.assign(short_read.begin(), short_read.end());
+  REQUIRE(std::ranges::equal(v, short_read));
+  REQUIRE(r.allocations == 0);
+  SECTION("spill and shrink") {
+    v.push_back(3);
+    REQUIRE(r.allocations == 1);
+    REQUIRE(v.capacity() > inline_size);
+    REQUIRE(v.back() == 3);
+    v.pop_back();
+    v.shrink_to_fit();
+    REQUIRE(v.capacity() == inline_size);
+    REQUIRE(r.live == 0);
+    REQUIRE(std::ranges::equal(v, short_read));
+  }
+  SECTION("copy and move") {
+    Small w(v, &r);
+    REQUIRE(w == v);
+    Small x(std::move(w));
+    REQUIRE(w.empty());
+    REQUIRE(x == v);
+    Small y(expected.begin(), expected.end(), &r);
+    x = std::move(y);
+    REQUIRE(std::ranges::equal(x, expected));
+    y = v;
+    REQUIRE(y == v);
+    REQUIRE(r.live == 1);
+  }
+  SECTION("swap") {
+    Small w(expected.begin(), expected.end(), &r);
+    v.swap(w);
+    REQUIRE(std::ranges::equal(v, expected));
+    REQUIRE(std::ranges::equal(w, short_read));
+    Small x(&r);
+    x.swap(w);
+    REQUIRE(w.empty());
+    REQUIRE(std::ranges::equal(x, short_read));
+    REQUIRE(r.allocations == 1);
+  }
+  SECTION("free functions") {
+    std::string s(v.size(), ' ');
+    unpack_ascii(v, s.data());
+    Small w(&r);
+    REQUIRE(pack_ascii(s, w) == 0);
+    REQUIRE(w == v);
+    REQUIRE(std::ranges::equal(DibitSpan<const TestType>(v), short_read));
+    REQUIRE(std::ranges::distance(kmers(v, 4)) == static_cast<std::ptrdiff_t>(inline_size - 3));
+  }
+  SECTION("save, load and parallel kernels") {
+    const auto path = std::filesystem::temp_directory_path() /
+                      ("xbit_vector_small_" + std::to_string(sizeof(TestType)) + ".xbv");
+    save(v, path);
+    Small w(&r);
+    load(path, w);
+    REQUIRE(w == v);
+    std::filesystem::remove(path);
+    ThreadPool pool(2);
+    flip(pool, w);
+    REQUIRE(count(pool, w, 0) == v.count(3));
+    fill(pool, w, 1);
+    REQUIRE(histogram(pool, w)[1] == inline_size);
+    std::string s(v.size(), ' ');
+    unpack_ascii(pool, v, s.data());
+    w.clear();
+    REQUIRE(pack_ascii(pool, s, w) == 0);
+    REQUIRE(equal(pool, w, v));
+    reverse_complement(pool, w);
+    Small rc(v, &r);
+    rc.reverse_complement();
+    REQUIRE(w == rc);
+  }
+}
+
+TEMPLATE_TEST_CASE_SIG("arbitrary widths", "", ((std::size_t N, typename B), N, B),
+                       (1, std::uint8_t), (3, std::uint8_t), (5, std::uint8_t),
+                       (6, std::uint16_t), (7, std::uint32_t), (8, std::uint8_t),
+                       (12, std::uint8_t), (13, std::uint64_t), (16, std::uint8_t),
+                       (16, std::uint16_t)) {
+  using V = XbitVector<N, B>;
+  using T = typename V::value_type;
+  constexpr std::size_t n = 500;
+  STATIC_REQUIRE(std::same_as<T, std::conditional_t<(N <= 8), std::uint8_t, std::uint16_t>>);
+  auto model = make_sequence<std::vector<std::uint16_t>>(n, 3);
+  for (auto& x : model) x &= (1 << N) - 1;
+  V v(model.begin(), model.end());
+  REQUIRE(v.size() == n);
+  REQUIRE(v.num_blocks() == (n * N + sizeof(B) * CHAR_BIT - 1) / (sizeof(B) * CHAR_BIT));
+  REQUIRE(v.capacity() >= n);
+  REQUIRE(std::ranges::equal(v, model));
+  REQUIRE(std::ranges::equal(v | std::views::reverse, model | std::views::reverse));
+  for (std::size_t i = 0; i < n; i += 37) {
+    REQUIRE(v[i] == model[i]);
+    REQUIRE(v.end() - (v.begin() + i) == static_cast<std::ptrdiff_t>(n - i));
+    REQUIRE(*(v.end() - (n - i)) == model[i]);
+  }
+  SECTION("modify") {
+    const T x = static_cast<T>((1 << N) - 1);
+    v[7] = x;
+    model[7] = x;
+    v.insert(v.begin() + 11, 30, x);
+    model.insert(model.begin() + 11, 30, x);
+    v.erase(v.begin() + 100, v.begin() + 131);
+    model.erase(model.begin() + 100, model.begin() + 131);
+    v.resize(700, 1);
+    model.resize(700, 1);
+    std::fill(v.begin() + 3, v.begin() + 290, x);
+    std::fill(model.begin() + 3, model.begin() + 290, x);
+    std::copy(v.begin() + 250, v.begin() + 450, v.begin() + 1);
+    std::copy(model.begin() + 250, model.begin() + 450, model.begin() + 1);
+    REQUIRE(std::ranges::equal(v, model));
+    REQUIRE(v.count(x) == static_cast<std::size_t>(std::ranges::count(model, x)));
+    REQUIRE(v.find(0) - v.begin() == std::ranges::find(model, 0) - model.begin());
+    const auto first = model[0];
+    const auto not_first = std::ranges::find_if(model, [&](auto y) { return y != first; });
+    REQUIRE(v.find_not(first) - v.begin() == not_first - model.begin());
+  }
+  SECTION("compare") {
+    V w(v);
+    REQUIRE(w == v);
+    w.back() = static_cast<T>(~w.back());
+    REQUIRE(w != v);
+    REQUIRE((w <=> v) == (model.back() > w.back() ? std::strong_ordering::less
+                                                   : std::strong_ordering::greater));
+    REQUIRE(mismatch(v.begin(), v.end(), w.begin()).first == v.end() - 1);
+    w.assign(v.begin() + 1, v.end());
+    REQUIRE(std::ranges::equal(w, model | std::views::drop(1)));
+    REQUIRE(XbitSpan<N, const B>(v).subspan(1) == XbitSpan<N, const B>(w));
+  }
+}
+
+TEMPLATE_TEST_CASE("string sets", "", std::uint8_t, std::uint16_t, std::uint32_t,
+                   std::uint64_t) {
+  using namespace biomodern;
+  using Set = DibitStringSet<TestType>;
+  STATIC_REQUIRE(std::random_access_iterator<typename Set::iterator>);
+  STATIC_REQUIRE(std::random_access_iterator<typename Set::const_iterator>);
+  STATIC_REQUIRE(std::ranges::random_access_range<const Set>);
+  const auto genome = make_sequence<DibitVector<TestType>>(2000, 5);
+  std::vector<DibitVector<TestType>> expected;
+  Set s;
+  s.reserve(40, 1000);
+  REQUIRE(s.empty());
+  for (std::size_t i = 0; i < 40; ++i) {
+    const auto n = i * 7 % 61;
+    const auto span = DibitSpan<const TestType>(genome).subspan(i * 37 % 101, n);
+    expected.emplace_back(span.begin(), span.end());
+    if (i % 3 == 0) s.push_back(span);
+    else if (i % 3 == 1) s.push_back(to_bytes(span));
+    else
+      s.push_back(std::views::iota(std::size_t{0}) | std::views::take(n) |
+                  std::views::transform([&](std::size_t j) { return expected.back()[j]; }));
+  }
+  s.push_back(std::vector<int>{});
+  expected.emplace_back();
+  auto total = std::size_t{0};
+  for (const auto& e : expected) total += e.size();
+  REQUIRE(s.size() == expected.size());
+  REQUIRE(s.total_size() == total);
+  REQUIRE(s.offsets().back() == total);
+  REQUIRE(s.back().empty());
+  for (std::size_t i = 0; i < expected.size(); ++i)
+    REQUIRE(std::ranges::equal(s[i], expected[i]));
+  REQUIRE(std::ranges::equal(s, expected, std::ranges::equal));
+  REQUIRE(std::ranges::equal(s | std::views::reverse, expected | std::views::reverse,
+                             std::ranges::equal));
+  REQUIRE((s.end() - s.begin()) == static_cast<std::ptrdiff_t>(s.size()));
+
+  SECTION("modify") {
+    s[1].flip();
+    expected[1].flip();
+    REQUIRE(std::ranges::equal(s[0], expected[0]));
+    REQUIRE(std::ranges::equal(s[1], expected[1]));
+    REQUIRE(std::ranges::equal(s[2], expected[2]));
+    auto e = s.emplace_back(10);
+    REQUIRE(pack_ascii("ACGTNACGTA", e) == 1);
+    REQUIRE(to_bytes(s.back()) == std::vector<std::uint8_t>{0, 1, 2, 3, 0, 0, 1, 2, 3, 0});
+    s.pop_back();
+    s.pop_back();
+    REQUIRE(s.size() == expected.size() - 1);
+    REQUIRE(s.total_size() == total - expected.back().size());
+    auto t = s;
+    REQUIRE(t == s);
+    t.clear();
+    REQUIRE(t.empty());
+    REQUIRE(t.total_size() == 0);
+    swap(s, t);
+    REQUIRE(s.empty());
+    REQUIRE(t.size() == expected.size() - 1);
+  }
+
+  SECTION("push back own sequences") {
+    // Every push may reallocate the buffer the pushed sequence lives in.
+    for (std::size_t i = 0; i < 200; ++i) {
+      const auto j = i * 13 % s.size();
+      expected.push_back(expected[j]);
+      s.push_back(s[j]);
+      REQUIRE(std::ranges::equal(s.back(), expected.back()));
+    }
+    REQUIRE(std::ranges::equal(s, expected, std::ranges::equal));
+  }
+
+  SECTION("save and load") {
+    const auto path = std::filesystem::temp_directory_path() /
+                      ("xbit_string_set_test_" + std::to_string(sizeof(TestType)) + ".xbs");
+    save(s, path);
+    REQUIRE(load<Set>(path) == s);
+    const auto w = load<DibitStringSet<std::uint64_t>>(path);
+    REQUIRE(std::ranges::equal(w, s, std::ranges::equal));
+    REQUIRE_THROWS_AS(load<QuadbitStringSet<TestType>>(path), std::runtime_error);
+    REQUIRE_THROWS_AS(load<DibitVector<TestType>>(path), std::runtime_error);
+    std::filesystem::remove(path);
+    std::stringstream blob;
+    save(s, blob);
+    // The payload is padded as in a saved XbitVector, so every blob spans whole 8-byte words.
+    Set odd;
+    odd.push_back(DibitVector<TestType>(37, 1));
+    std::stringstream odd_blob;
+    save(odd, odd_blob);
+    REQUIRE(odd_blob.str().size() % 8 == 0);
+    save(Set{}, blob);
+    Set u, v;
+    load(blob, u);
+    load(blob, v);
+    REQUIRE(u == s);
+    REQUIRE(v.empty());
+    REQUIRE_THROWS_AS(load(blob, u), std::runtime_error);
+  }
+
+  SECTION("allocators") {
+    CountingResource r;
+    DibitStringSet<TestType, std::pmr::polymorphic_allocator<TestType>> p(&r);
+    for (const auto& e : expected) p.push_back(e);
+    REQUIRE(std::ranges::equal(p, expected, std::ranges::equal));
+    REQUIRE(p.get_allocator().resource() == &r);
+    REQUIRE(r.allocations > 0);
+  }
+}
+
+TEMPLATE_TEST_CASE("hamming distance", "", std::uint8_t, std::uint16_t, std::uint32_t,
+                   std::uint64_t) {
+  using namespace biomodern;
+  const auto check = [](const auto& a, const auto& b) {
+    const auto x = to_bytes(a), y = to_bytes(b);
+    for (std::size_t ap : {0, 1, 3, 17, 64})
+      for (std::size_t bp : {0, 2, 5, 33, 64})
+        for (std::size_t len : {0, 1, 31, 32, 33, 100, 300}) {
+          std::size_t expected = 0;
+          for (std::size_t i = 0; i < len; ++i) expected += x[ap + i] != y[bp + i];
+          REQUIRE(hamming(a, ap, b, bp, len) == expected);
+          REQUIRE(hamming(a.begin() + ap, a.begin() + (ap + len), b.begin() + bp) == expected);
+          for (std::size_t k : {0, 1, 5, 100})
+            REQUIRE(hamming_at_most(a, ap, b, bp, len, k) == std::min(expected, k + 1));
+        }
+  };
+  const auto d = make_sequence<DibitVector<TestType>>(400, 3);
+  auto e = d;
+  for (std::size_t i = 0; i < e.size(); i += 7) e[i] = static_cast<std::uint8_t>(e[i] + 1);
+  check(d, e);
+  check(d, make_sequence<DibitVector<std::uint8_t>>(400, 4));
+  check(DibitSpan<const TestType>(d).subspan(3), DibitSpan<const TestType>(e).subspan(1));
+  check(make_sequence<QuadbitVector<TestType>>(400, 5),
+        make_sequence<QuadbitVector<TestType>>(400, 6));
+  check(make_sequence<XbitVector<1, TestType>>(400, 7),
+        make_sequence<XbitVector<1, TestType>>(400));
+  REQUIRE(hamming(d, 5, d, 5, 300) == 0);
+  REQUIRE(hamming_at_most(d, 0, e, 0, 400, 0) == 1);
+}
+
+// Last row of the edit distance matrix of pattern against every prefix of text, free leading
+// text symbols when local is set.
+std::vector<std::size_t> edit_distance_row(
+    const std::vector<std::uint8_t>& p, const std::vector<std::uint8_t>& t, bool local) {
+  std::vector<std::size_t> col(p.size() + 1), row(t.size() + 1);
+  for (std::size_t i = 0; i <= p.size(); ++i) col[i] = i;
+  row[0] = p.size();
+  for (std::size_t j = 1; j <= t.size(); ++j) {
+    std::size_t diag = col[0];
+    col[0] = local ? 0 : j;
+    for (std::size_t i = 1; i <= p.size(); ++i) {
+      const auto up = col[i];
+      col[i] = std::min({up + 1, col[i - 1] + 1, diag + (p[i - 1] != t[j - 1])});
+      diag = up;
+    }
+    row[j] = col[p.size()];
+  }
+  return row;
+}
+
+TEMPLATE_TEST_CASE("edit distance", "", std::uint8_t, std::uint16_t, std::uint32_t,
+                   std::uint64_t) {
+  using namespace biomodern;
+  const auto check = [](const auto& pattern, const auto& text) {
+    const auto p = to_bytes(pattern), t = to_bytes(text);
+    const auto local = edit_distance_row(p, t, true);
+    for (std::size_t k : {0, 3, 10, 40, 100}) {
+      std::vector<ApproximateMatch> expected;
+      for (std::size_t j = 0; j <= t.size(); ++j)
+        if (local[j] <= k) expected.push_back({j, local[j]});
+      REQUIRE(approximate_matches(pattern, text, k) == expected);
+    }
+    const auto global = edit_distance_row(p, t, false).back();
+    REQUIRE(edit_distance(pattern, text) == global);
+    for (std::size_t band : {0, 1, 5, 20, 64, 100, 300})
+      REQUIRE(edit_distance(pattern, text, band) == std::min(global, band + 1));
+  };
+  // A mutated copy of v: substitutions, insertions and deletions every few symbols.
+  const auto mutate = [](auto v, unsigned step) {
+    for (std::size_t i = 1; i < v.size(); i += step) {
+      if (i % 3 == 0) v[i] = static_cast<std::uint8_t>(v[i] + 1);
+      else if (i % 3 == 1) v.insert(v.begin() + i, 0);
+      else
+        v.erase(v.begin() + i);
+    }
+    return v;
+  };
+  for (std::size_t m : {0, 1, 20, 64, 65, 150, 300}) {
+    const auto d = make_sequence<DibitVector<TestType>>(m, static_cast<unsigned>(m));
+    for (unsigned step : {7, 40}) {
+      const auto e = mutate(d, step);
+      auto text = make_sequence<DibitVector<TestType>>(50, 9);
+      text.insert(text.end(), e.begin(), e.end());
+      const auto tail = make_sequence<DibitVector<TestType>>(30, 11);
+      text.insert(text.end(), tail.begin(), tail.end());
+      check(d, text);
+      check(d, e);
+      check(e, d);
+      check(DibitSpan<const TestType>(text).subspan(3), d);
+    }
+    const auto q = make_sequence<QuadbitVector<TestType>>(m, static_cast<unsigned>(m) + 1);
+    check(q, mutate(q, 5));
+  }
+  const DibitMyersPattern pattern(make_sequence<DibitVector<TestType>>(100, 4));
+  REQUIRE(pattern.size() == 100);
+  REQUIRE(pattern.distance(make_sequence<DibitVector<TestType>>(100, 4)) == 0);
+}
+
+TEMPLATE_TEST_CASE_SIG("word access", "", ((std::size_t N, typename B), N, B), (2, std::uint8_t),
+                       (2, std::uint16_t), (2, std::uint32_t), (2, std::uint64_t),
+                       (4, std::uint8_t), (4, std::uint64_t), (5, std::uint8_t),
+                       (5, std::uint32_t)) {
+  using namespace biomodern;
+  auto v = make_sequence<XbitVector<N, B>>(300, 13);
+  auto model = std::vector<std::uint16_t>(v.begin(), v.end());
+  const auto compose = [&](std::size_t pos, std::size_t count) {
+    std::uint64_t x = 0;
+    for (std::size_t i = count; i-- > 0;) x = x << N | model[pos + i];
+    return x;
+  };
+  for (std::size_t pos = 0; pos < 100; ++pos)
+    for (std::size_t count = 1; count * N <= 64; ++count) {
+      REQUIRE(v.get_bits(pos, count) == compose(pos, count));
+      REQUIRE(XbitSpan<N, const B>(v).subspan(pos).get_bits(0, count) == compose(pos, count));
+    }
+  std::uint64_t seed = 7;
+  for (std::size_t pos = 0; pos < 200; pos += 3) {
+    const std::size_t count = 1 + pos % (64 / N);
+    seed = seed * 6364136223846793005u + 1442695040888963407u;
+    if (pos % 2) v.set_bits(pos, count, seed);
+    else
+      XbitSpan<N, B>(v).subspan(pos, count).set_bits(0, count, seed);
+    for (std::size_t i = 0; i < count; ++i)
+      model[pos + i] = static_cast<std::uint16_t>(seed >> (i * N) & ((1u << N) - 1));
+    REQUIRE(std::ranges::equal(v, model));
+  }
+}
+
+TEMPLATE_TEST_CASE_SIG("substr and append", "", ((std::size_t N, typename B), N, B),
+                       (2, std::uint8_t), (2, std::uint16_t), (2, std::uint32_t),
+                       (2, std::uint64_t), (4, std::uint8_t), (4, std::uint64_t), (5, std::uint8_t),
+                       (5, std::uint32_t)) {
+  using namespace biomodern;
+  const auto v = make_sequence<XbitVector<N, B>>(500, 29);
+  const auto model = std::vector<std::uint16_t>(v.begin(), v.end());
+  const auto slice = [&](std::size_t pos, std::size_t len) {
+    return std::vector<std::uint16_t>(model.begin() + pos, model.begin() + pos + len);
+  };
+  for (std::size_t pos : {0, 1, 3, 7, 31, 64, 65, 200})
+    for (std::size_t len : {0, 1, 5, 32, 63, 64, 65, 129, 300}) {
+      const auto s = v.substr(pos, len);
+      REQUIRE(std::ranges::equal(s, slice(pos, len)));
+      REQUIRE(s.capacity() >= len);
+    }
+  REQUIRE(std::ranges::equal(v.substr(450), slice(450, 50)));
+  REQUIRE(v.substr(500).empty());
+  REQUIRE(v.substr() == v);
+  REQUIRE_THROWS_AS(v.substr(501), std::out_of_range);
+
+  auto scaffold = XbitVector<N, B>{};
+  auto expected = std::vector<std::uint16_t>{};
+  for (std::size_t i = 0; i < 40; ++i) {
+    const std::size_t pos = i * 37 % 450, len = i * 13 % 70;
+    if (i % 2) scaffold.append(v, pos, len);
+    else
+      scaffold.append(XbitSpan<N, const B>(v).subspan(pos, len));
+    expected.insert(expected.end(), model.begin() + pos, model.begin() + pos + len);
+    REQUIRE(std::ranges::equal(scaffold, expected));
+  }
+  // Appending from itself, both within the capacity and while reallocating.
+  scaffold.shrink_to_fit();
+  for (std::size_t pos : {5, 0, 17}) {
+    const auto tail = std::vector<std::uint16_t>(expected.begin() + pos, expected.end());
+    scaffold.append(scaffold, pos);
+    expected.insert(expected.end(), tail.begin(), tail.end());
+    REQUIRE(std::ranges::equal(scaffold, expected));
+    scaffold.reserve(scaffold.size() * 3);
+  }
+  REQUIRE_THROWS_AS(scaffold.append(v, 501), std::out_of_range);
+}
+
+TEMPLATE_TEST_CASE_SIG("counting sort", "", ((std::size_t N, typename B), N, B), (1, std::uint8_t),
+                       (2, std::uint8_t), (2, std::uint16_t), (2, std::uint32_t),
+                       (2, std::uint64_t), (3, std::uint8_t), (4, std::uint8_t),
+                       (4, std::uint64_t), (5, std::uint32_t), (8, std::uint16_t)) {
+  using namespace biomodern;
+  const auto v = make_sequence<XbitVector<N, B>>(1000, 31);
+  const auto model = std::vector<std::uint16_t>(v.begin(), v.end());
+  auto w = v;
+  sort(w);
+  REQUIRE(std::ranges::is_sorted(w));
+  REQUIRE(w.histogram() == v.histogram());
+  for (std::size_t first : {0, 1, 7, 33, 100})
+    for (std::size_t last : {first, first + 1, first + 63, std::size_t{700}, std::size_t{1000}}) {
+      w = v;
+      auto expected = model;
+      std::sort(expected.begin() + first, expected.begin() + last);
+      if (first % 2) sort(w.begin() + first, w.begin() + last);
+      else
+        sort(XbitSpan<N, B>(w).subspan(first, last - first));
+      REQUIRE(std::ranges::equal(w, expected));
+    }
+}
+
+TEMPLATE_TEST_CASE_SIG("symbol transforms", "", ((std::size_t N, typename B), N, B),
+                       (2, std::uint8_t), (2, std::uint16_t), (2, std::uint32_t),
+                       (2, std::uint64_t), (4, std::uint8_t), (4, std::uint16_t),
+                       (4, std::uint64_t)) {
+  using namespace biomodern;
+  constexpr std::size_t n = 1000;
+  const auto v = make_sequence<XbitVector<N, B>>(n, 37);
+  const auto model = std::vector<std::uint16_t>(v.begin(), v.end());
+  // Complement, for quadbits the IUPAC one which reverses the bits, and an arbitrary mapping.
+  auto complement = std::array<std::uint8_t, (1 << N)>{};
+  auto scramble = std::array<std::uint8_t, (1 << N)>{};
+  for (std::size_t x = 0; x < complement.size(); ++x) {
+    complement[x] = static_cast<std::uint8_t>(
+        N == 2 ? 3 - x : (x & 1) << 3 | (x & 2) << 1 | (x & 4) >> 1 | (x & 8) >> 3);
+    scramble[x] = static_cast<std::uint8_t>((x * 7 + 3) % complement.size() | 0xf0);
+  }
+  if constexpr (N == 2) {
+    auto w = v;
+    transform_symbols(w, {3, 2, 1, 0});
+    w.flip();
+    REQUIRE(w == v);
+  }
+  for (const auto& lut : {complement, scramble}) {
+    const auto mapped = [&](std::size_t first, std::size_t last) {
+      auto r = model;
+      for (std::size_t i = first; i < last; ++i) r[i] = lut[r[i]] & ((1 << N) - 1);
+      return r;
+    };
+    auto w = XbitVector<N, B>{};
+    transform_symbols(v, w, lut);
+    REQUIRE(std::ranges::equal(w, mapped(0, n)));
+    w = v;
+    transform_symbols(w, lut);
+    REQUIRE(std::ranges::equal(w, mapped(0, n)));
+    transform_symbols(w, w, lut);
+    auto twice = mapped(0, n);
+    for (auto& x : twice) x = lut[x] & ((1 << N) - 1);
+    REQUIRE(std::ranges::equal(w, twice));
+    for (std::size_t first : {0, 1, 3, 17, 64, 100})
+      for (std::size_t last : {first, first + 1, first + 30, first + 70, std::size_t{n}}) {
+        w = v;
+        transform_symbols(XbitSpan<N, B>(w).subspan(first, last - first), lut);
+        REQUIRE(std::ranges::equal(w, mapped(first, last)));
+        // Destinations at the same and at other offsets in their blocks.
+        for (std::size_t shift : {0, 1, 5}) {
+          auto d = XbitVector<N, B>(n + shift, 0);
+          auto expected = std::vector<std::uint16_t>(n + shift, 0);
+          const auto m = mapped(first, last);
+          std::copy(m.begin() + first, m.begin() + last, expected.begin() + first + shift);
+          transform_symbols(
+              XbitSpan<N, const B>(v).subspan(first, last - first),
+              XbitSpan<N, B>(d).subspan(first + shift), lut);
+          REQUIRE(std::ranges::equal(d, expected));
+        }
+      }
+  }
+}
+
+TEMPLATE_TEST_CASE("widen and narrow", "", std::uint8_t, std::uint16_t, std::uint32_t,
+                   std::uint64_t) {
+  using namespace biomodern;
+  constexpr std::size_t n = 1000;
+  const auto d = make_sequence<DibitVector<TestType>>(n, 41);
+  const auto q = make_sequence<QuadbitVector<TestType>>(n, 43);
+  const auto decode = [](std::uint16_t x, DibitEncoding e) -> int {
+    if (e == DibitEncoding::zero_extended) return x < 4 ? x : -1;
+    return std::has_single_bit(x) ? std::countr_zero(x) : -1;
+  };
+  for (const auto e : {DibitEncoding::zero_extended, DibitEncoding::one_hot}) {
+    const auto encode = [&](std::uint16_t x) {
+      return e == DibitEncoding::zero_extended ? x : static_cast<std::uint16_t>(1 << x);
+    };
+    const auto w = widen(d, e);
+    REQUIRE(w.size() == n);
+    REQUIRE(std::ranges::equal(w, d, {}, {}, encode));
+    REQUIRE(narrow(w, e) == d);
+
+    auto invalid = std::vector<std::size_t>{};
+    const auto r = narrow(q, e, [&](std::size_t i) { invalid.push_back(i); });
+    auto expected_invalid = std::vector<std::size_t>{};
+    for (std::size_t i = 0; i < n; ++i) {
+      const int x = decode(q[i], e);
+      if (x < 0) expected_invalid.push_back(i);
+      REQUIRE(r[i] == std::max(x, 0));
+    }
+    REQUIRE(invalid == expected_invalid);
+    REQUIRE(!invalid.empty());
+
+    // Sub-ranges at other offsets in their blocks.
+    for (std::size_t first : {0, 1, 3, 17, 33})
+      for (std::size_t last : {first, first + 1, first + 16, first + 40, std::size_t{n}})
+        for (std::size_t shift : {0, 1, 5}) {
+          auto wide = QuadbitVector<TestType>(n + shift, 15);
+          auto it = widen(d.begin() + first, d.begin() + last, wide.begin() + shift, e);
+          REQUIRE(it == wide.begin() + shift + (last - first));
+          for (std::size_t i = 0; i < n + shift; ++i) {
+            const bool inside = i >= shift && i < shift + last - first;
+            REQUIRE(wide[i] == (inside ? encode(d[first + i - shift]) : 15));
+          }
+          auto thin = DibitVector<TestType>(n + shift, 3);
+          std::size_t calls = 0;
+          const auto count = narrow(
+              q.begin() + first, q.begin() + last, thin.begin() + shift, e, [&](std::size_t i) {
+                REQUIRE(decode(q[first + i], e) < 0);
+                ++calls;
+              });
+          REQUIRE(count == calls);
+          for (std::size_t i = 0; i < n + shift; ++i) {
+            const bool inside = i >= shift && i < shift + last - first;
+            REQUIRE(thin[i] == (inside ? std::max(decode(q[first + i - shift], e), 0) : 3));
+          }
+        }
+  }
+  // One-hot quadbits are the IUPAC codes.
+  auto acgt = DibitVector<TestType>{};
+  auto iupac = QuadbitVector<TestType>{};
+  pack_ascii("GATTACAGATTACA", acgt);
+  pack_iupac("GATTACAGATTACA", iupac);
+  REQUIRE(widen(acgt, DibitEncoding::one_hot) == iupac);
+  REQUIRE(narrow(iupac, DibitEncoding::one_hot) == acgt);
+}